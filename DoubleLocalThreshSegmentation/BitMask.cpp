@@ -0,0 +1,229 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  BitMask.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "BitMask.h"
+
+//********** word helpers ****************************************************************************
+
+static inline int popcount64(uint64 w)
+{
+#ifdef _MSC_VER
+	return (int)__popcnt64(w);
+#else
+	return __builtin_popcountll(w);
+#endif
+}
+
+// word q of a row, zero outside [0, words)
+static inline uint64 wordAt(const uint64* src, int words, int q)
+{
+	return (q >= 0 && q < words) ? src[q] : 0;
+}
+
+// ORs a shifted source row into dst[w0, w1): bit x of dst receives bit x+shift of src
+static void orShifted(uint64* dst, int w0, int w1, const uint64* src, int srcWords, int shift)
+{
+	for(int w = w0; w < w1; ++w){
+		int b = w*64 + shift;
+		int q = b >= 0 ? b / 64 : -((-b + 63) / 64);
+		int r = b - q*64;
+		uint64 word = wordAt(src, srcWords, q) >> r;
+		if(r)
+			word |= wordAt(src, srcWords, q+1) << (64 - r);
+		dst[w] |= word;
+	}
+}
+
+//********** class BitMask *******************************************************
+
+BitMask::BitMask()
+	: _rows(0), _cols(0), _stride(0)
+{
+
+}
+
+BitMask::BitMask(Size size)
+	: _rows(0), _cols(0), _stride(0)
+{
+	create(size);
+}
+
+BitMask::BitMask(const Mat& img)
+	: _rows(0), _cols(0), _stride(0)
+{
+	fromMat(img);
+}
+
+void BitMask::create(Size size, int* allocCounter)
+{
+	_rows = size.height;
+	_cols = size.width;
+	_stride = (_cols + 63) / 64;
+	size_t n = (size_t)_rows * _stride;
+	if(n > _words.capacity() && allocCounter)
+		CV_XADD(allocCounter, 1);
+	_words.assign(n, 0);
+}
+
+void BitMask::setTo(bool value)
+{
+	std::fill(_words.begin(), _words.end(), value ? ~(uint64)0 : 0);
+	if(value)
+		clearPadding();
+}
+
+// Packs a CV_8U mask
+//     img          - input mask, non-zero pixels are set
+//     allocCounter - incremented when the storage grows
+//
+void BitMask::fromMat(const Mat& img, int* allocCounter)
+{
+	CV_Assert(img.type() == CV_8U);
+	create(img.size(), allocCounter);
+	for(int y = 0; y < _rows; ++y){
+		const uchar* imgRow = img.ptr<uchar>(y);
+		uint64* bits = row(y);
+		for(int w = 0; w < _stride; ++w){
+			int x0 = w*64;
+			int n = std::min(64, _cols - x0);
+			uint64 word = 0;
+			for(int i = 0; i < n; ++i)
+				word |= (uint64)(imgRow[x0 + i] != 0) << i;
+			bits[w] = word;
+		}
+	}
+}
+
+// Unpacks into a CV_8U mask
+//     dst   - output mask
+//     value - value of set pixels, others are 0
+//
+void BitMask::toMat(OutputArray dst, uchar value) const
+{
+	dst.create(size(), CV_8U);
+	Mat outImg = dst.getMat();
+	for(int y = 0; y < _rows; ++y){
+		const uint64* bits = row(y);
+		uchar* outRow = outImg.ptr<uchar>(y);
+		for(int x = 0; x < _cols; ++x)
+			outRow[x] = ((bits[x >> 6] >> (x & 63)) & 1) ? value : 0;
+	}
+}
+
+BitMask& BitMask::operator&=(const BitMask& other)
+{
+	CV_Assert(size() == other.size());
+	for(size_t i = 0; i < _words.size(); ++i)
+		_words[i] &= other._words[i];
+	return *this;
+}
+
+BitMask& BitMask::operator|=(const BitMask& other)
+{
+	CV_Assert(size() == other.size());
+	for(size_t i = 0; i < _words.size(); ++i)
+		_words[i] |= other._words[i];
+	return *this;
+}
+
+// clears the pixels set in other
+BitMask& BitMask::andNot(const BitMask& other)
+{
+	CV_Assert(size() == other.size());
+	for(size_t i = 0; i < _words.size(); ++i)
+		_words[i] &= ~other._words[i];
+	return *this;
+}
+
+// ORs a smaller mask into this one
+//     src    - mask to add
+//     offset - position of the top-left pixel of src in this mask
+//
+void BitMask::orAt(const BitMask& src, Point offset)
+{
+	int y0 = std::max(0, offset.y);
+	int y1 = std::min(_rows, offset.y + src._rows);
+	int x0 = std::max(0, offset.x);
+	int x1 = std::min(_cols, offset.x + src._cols);
+	if(y0 >= y1 || x0 >= x1)
+		return;
+
+	int w0 = x0 / 64;
+	int w1 = (x1 + 63) / 64;
+	for(int y = y0; y < y1; ++y)
+		orShifted(row(y), w0, w1, src.row(y - offset.y), src._stride, -offset.x);
+	clearPadding();
+}
+
+int64 BitMask::area() const
+{
+	int64 count = 0;
+	for(size_t i = 0; i < _words.size(); ++i)
+		count += popcount64(_words[i]);
+	return count;
+}
+
+// Binary dilation, pixels outside the mask are treated as unset
+//     dst   - output mask
+//     spans - structuring element
+//
+void BitMask::dilate(BitMask& dst, const vector<MorphSpan>& spans) const
+{
+	CV_Assert(&dst != this);
+	dst.create(size());
+	for(int y = 0; y < _rows; ++y){
+		uint64* outRow = dst.row(y);
+		for(size_t i = 0; i < spans.size(); ++i){
+			int yIn = y + spans[i].dy;
+			if(yIn < 0 || yIn >= _rows)
+				continue;
+			const uint64* inRow = row(yIn);
+			for(int d = -spans[i].left; d <= spans[i].right; ++d)
+				orShifted(outRow, 0, _stride, inRow, _stride, d);
+		}
+	}
+	dst.clearPadding();
+}
+
+// Binary erosion, pixels outside the mask are treated as set
+// by duality, the complement of the dilation of the complement
+//     dst   - output mask
+//     spans - structuring element
+//
+void BitMask::erode(BitMask& dst, const vector<MorphSpan>& spans) const
+{
+	BitMask inverse(*this);
+	inverse.complement();
+	inverse.dilate(dst, spans);
+	dst.complement();
+}
+
+uint64 BitMask::lastWordMask() const
+{
+	int r = _cols & 63;
+	return r ? (((uint64)1 << r) - 1) : ~(uint64)0;
+}
+
+void BitMask::clearPadding()
+{
+	if(_stride == 0) return;
+	uint64 mask = lastWordMask();
+	for(int y = 0; y < _rows; ++y)
+		row(y)[_stride - 1] &= mask;
+}
+
+void BitMask::complement()
+{
+	for(size_t i = 0; i < _words.size(); ++i)
+		_words[i] = ~_words[i];
+	clearPadding();
+}
@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  BitMask.h
+//  Date:   Oct/16/2026
+//
+//  Binary mask with one bit per pixel. Each row is packed into 64-bit
+//  words, leftmost pixel in the lowest bit, and the bits past the last
+//  column are always zero, so logic operations and area are computed a
+//  whole word (64 pixels) at a time on 1/8 of the memory of a CV_8U mask.
+//
+
+#ifndef _BITMASK_H_
+#define _BITMASK_H_
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "Morphology.h"
+
+using namespace std;
+using namespace cv;
+
+//********** class BitMask *******************************************************
+
+class BitMask
+{
+public:
+	BitMask();
+	explicit BitMask(Size size);
+	explicit BitMask(const Mat& img);
+
+	// (re)shapes the mask and clears it; the storage only grows, so reusing
+	// a mask for smaller or equal sizes never allocates
+	//     allocCounter - incremented when the storage grows
+	void create(Size size, int* allocCounter = 0);
+	void setTo(bool value);
+
+	int rows() const { return _rows; }
+	int cols() const { return _cols; }
+	Size size() const { return Size(_cols, _rows); }
+	bool empty() const { return _rows == 0 || _cols == 0; }
+	int wordsPerRow() const { return _stride; }
+
+	uint64* row(int y) { return &_words[(size_t)y*_stride]; }
+	const uint64* row(int y) const { return &_words[(size_t)y*_stride]; }
+	bool at(int y, int x) const { return (row(y)[x >> 6] >> (x & 63)) & 1; }
+
+	// conversions, any non-zero pixel is set
+	void fromMat(const Mat& img, int* allocCounter = 0);
+	void toMat(OutputArray dst, uchar value = 255) const;
+
+	// word-wide logic with a mask of the same size
+	BitMask& operator&=(const BitMask& other);
+	BitMask& operator|=(const BitMask& other);
+	BitMask& andNot(const BitMask& other);
+
+	// ORs src into this mask with its top-left corner at offset, clipped
+	void orAt(const BitMask& src, Point offset);
+
+	// number of set pixels
+	int64 area() const;
+
+	// binary erosion and dilation with a span structuring element, same
+	// border handling as cv::erode/cv::dilate; dst must not be this mask
+	void erode(BitMask& dst, const vector<MorphSpan>& spans) const;
+	void dilate(BitMask& dst, const vector<MorphSpan>& spans) const;
+
+private:
+	int				_rows;
+	int				_cols;
+	int				_stride;	// words per row
+	vector<uint64>	_words;
+
+	uint64 lastWordMask() const;
+	void clearPadding();
+	void complement();
+};
+
+#endif
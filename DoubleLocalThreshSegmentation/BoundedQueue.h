@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  BoundedQueue.h
+//  Date:   Oct/16/2026
+//
+//  Blocking FIFO queue with a fixed capacity, used to connect the stages
+//  of a processing pipeline. A full queue blocks its producer, so a fast
+//  stage can never run ahead of a slow one by more than the capacity.
+//
+
+#ifndef _BOUNDEDQUEUE_H_
+#define _BOUNDEDQUEUE_H_
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+//********** class BoundedQueue **************************************************
+
+template<class T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(size_t capacity)
+		: _capacity(capacity > 0 ? capacity : 1), _closed(false)
+	{
+
+	}
+
+	// appends an item, blocking while the queue is full
+	// returns false if the queue has been closed
+	bool push(const T& item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while(!_closed && _items.size() >= _capacity)
+			_notFull.wait(lock);
+		if(_closed)
+			return false;
+		_items.push_back(item);
+		_notEmpty.notify_one();
+		return true;
+	}
+
+	// removes the oldest item, blocking while the queue is empty
+	// returns false once the queue is closed and drained
+	bool pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while(!_closed && _items.empty())
+			_notEmpty.wait(lock);
+		if(_items.empty())
+			return false;
+		item = _items.front();
+		_items.pop_front();
+		_notFull.notify_one();
+		return true;
+	}
+
+	// marks the end of the stream and wakes up all waiting threads
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_closed = true;
+		_notFull.notify_all();
+		_notEmpty.notify_all();
+	}
+
+	size_t size() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _items.size();
+	}
+
+	size_t capacity() const { return _capacity; }
+
+private:
+	mutable std::mutex		_mutex;
+	std::condition_variable	_notFull;
+	std::condition_variable	_notEmpty;
+	std::deque<T>			_items;
+	size_t					_capacity;
+	bool					_closed;
+
+	BoundedQueue(const BoundedQueue&);
+	BoundedQueue& operator=(const BoundedQueue&);
+};
+
+#endif
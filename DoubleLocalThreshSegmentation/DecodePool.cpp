@@ -0,0 +1,96 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  DecodePool.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <algorithm>
+
+#include <opencv2/highgui/highgui.hpp>
+
+#include "DecodePool.h"
+
+//********** class DecodePool ****************************************************
+
+DecodePool::DecodePool(const vector<string>& filenames, int threads, int capacity)
+	: _filenames(filenames), _nextTask(0), _nextOut(0), _stop(false),
+	  _frames(0), _decodeTicks(0), _waitTicks(0)
+{
+	if(threads <= 0)
+		threads = std::max((int)std::thread::hardware_concurrency(), 1);
+	_capacity = capacity > 0 ? (size_t)capacity : 2 * (size_t)threads;
+	for(int i = 0; i < threads; ++i)
+		_threads.push_back(std::thread(&DecodePool::run, this));
+}
+
+DecodePool::~DecodePool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_consumed.notify_all();
+	for(size_t i = 0; i < _threads.size(); ++i)
+		_threads[i].join();
+}
+
+// decodes images in list order until the list ends or the pool stops
+void DecodePool::run()
+{
+	for(;;){
+		size_t index;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			while(!_stop && _nextTask < _filenames.size() && _nextTask >= _nextOut + _capacity)
+				_consumed.wait(lock);
+			if(_stop || _nextTask >= _filenames.size())
+				return;
+			index = _nextTask++;
+		}
+
+		int64 start = getTickCount();
+		Mat img = imread(_filenames[index], 0);
+		int64 ticks = getTickCount() - start;
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_done[index] = img;
+			_decodeTicks += ticks;
+			++_frames;
+		}
+		_decoded.notify_all();
+	}
+}
+
+bool DecodePool::next(Mat& img, size_t* index)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	if(_nextOut >= _filenames.size())
+		return false;
+
+	int64 start = getTickCount();
+	map<size_t, Mat>::iterator it;
+	while((it = _done.find(_nextOut)) == _done.end())
+		_decoded.wait(lock);
+	_waitTicks += getTickCount() - start;
+
+	img = it->second;
+	_done.erase(it);
+	if(index)
+		*index = _nextOut;
+	++_nextOut;
+	lock.unlock();
+	_consumed.notify_all();
+	return true;
+}
+
+DecodeStats DecodePool::stats() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	DecodeStats stats;
+	stats.frames = _frames;
+	stats.decodeSeconds = _decodeTicks / getTickFrequency();
+	stats.waitSeconds = _waitTicks / getTickFrequency();
+	stats.threads = (int)_threads.size();
+	return stats;
+}
@@ -0,0 +1,82 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  DecodePool.h
+//  Date:   Oct/16/2026
+//
+//  Threads decoding a list of compressed images ahead of their consumer.
+//  Images are decoded straight to grayscale (libjpeg then only runs the
+//  inverse DCT of the luma channel and skips the color conversion), so
+//  FGExtraction gets frames it does not need to convert. Frames come out
+//  in list order however the threads finish, and the threads stop when
+//  they are capacity frames ahead of the consumer, so memory stays bounded.
+//
+
+#ifndef _DECODEPOOL_H_
+#define _DECODEPOOL_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <opencv2/core/core.hpp>
+
+using namespace std;
+using namespace cv;
+
+//********** struct DecodeStats **************************************************
+
+// decode work so far, kept apart from the work of the consumer
+struct DecodeStats
+{
+	size_t	frames;			// images decoded
+	double	decodeSeconds;	// decode time summed over the threads
+	double	waitSeconds;	// time the consumer spent waiting for a frame
+	int		threads;
+
+	// frames per second the pool can sustain with all threads busy
+	double throughput() const { return decodeSeconds > 0 ? frames * threads / decodeSeconds : 0; }
+};
+
+//********** class DecodePool ****************************************************
+
+class DecodePool
+{
+public:
+	// starts decoding
+	//     threads  - number of decode threads, 0 for one per hardware thread
+	//     capacity - how far the threads may run ahead, 0 for twice the threads
+	DecodePool(const vector<string>& filenames, int threads = 0, int capacity = 0);
+	~DecodePool();
+
+	// next image in list order, empty if it could not be read
+	//     index   - if not NULL, receives its position in the list
+	//     returns : false after the last image
+	bool next(Mat& img, size_t* index = NULL);
+
+	DecodeStats stats() const;
+
+private:
+	vector<string>				_filenames;
+	vector<std::thread>			_threads;
+	mutable std::mutex			_mutex;
+	std::condition_variable		_decoded;	// an image was added to _done
+	std::condition_variable		_consumed;	// the consumer took an image
+	map<size_t, Mat>			_done;		// decoded images not yet taken
+	size_t						_nextTask;	// next image to decode
+	size_t						_nextOut;	// next image to hand out
+	size_t						_capacity;
+	bool						_stop;
+	size_t						_frames;
+	int64						_decodeTicks;
+	int64						_waitTicks;
+
+	void run();
+
+	DecodePool(const DecodePool&);
+	DecodePool& operator=(const DecodePool&);
+};
+
+#endif
@@ -6,11 +6,396 @@
 //
 
 #include <iostream>
+#include <atomic>
+#include <exception>
 
 #include "FGExtraction.h"
+#include "WorkStealingPool.h"
+
+//********** class StageScope ****************************************************
+
+// Adds the wall time of a scope to one stage of the stats and emits it as a
+// trace event; with neither stats nor trace it only tests two pointers
+class StageScope
+{
+public:
+	StageScope(FGExtractionStats* stats, TraceSink* trace, int stage, int64 pixels)
+		: _stats(stats), _trace(trace), _stage(stage), _start(0)
+	{
+		if(!_stats && !_trace) return;
+		_start = getTickCount();
+		if(_stats)
+			_stats->stagePixels[stage] += pixels;
+	}
+
+	~StageScope()
+	{
+		if(!_stats && !_trace) return;
+		int64 end = getTickCount();
+		if(_stats)
+			_stats->stageMs[_stage] += ticksToMs(end - _start);
+		if(_trace)
+			_trace->complete(FGExtractionStats::stageName(_stage), "stage", _start, end);
+	}
+
+private:
+	FGExtractionStats*	_stats;
+	TraceSink*			_trace;
+	int					_stage;
+	int64				_start;
+};
+
+//********** class LocalRegionBody ***********************************************
+
+// Segments a range of local regions, one output slot per region
+class LocalRegionBody : public ParallelLoopBody
+{
+public:
+	LocalRegionBody(FGExtraction* fgExtraction, const Mat& inImg, const vector<RotatedRect>& orientedBoxes,
+					vector<Rect>& windows, vector<BitMask>& regionMasks, const vector<uchar>* recompute)
+		: _fgExtraction(fgExtraction), _inImg(inImg), _orientedBoxes(orientedBoxes),
+		  _windows(windows), _regionMasks(regionMasks), _recompute(recompute)
+	{
+
+	}
+
+	void operator()(const Range& range) const
+	{
+		FGExtractionStats* stats = _fgExtraction->_stats;
+		TraceSink* trace = _fgExtraction->_trace;
+		for(int i = range.start; i < range.end; ++i){
+			if(_recompute && !(*_recompute)[i])
+				continue;
+			int64 start = (stats || trace) ? getTickCount() : 0;
+			_fgExtraction->segmentLocalRegion(_inImg, _orientedBoxes[i], _windows[i], _regionMasks[i],
+											  _fgExtraction->_ws.regions[i]);
+			if(stats || trace)
+				recordRegion(stats, trace, i, start, getTickCount());
+		}
+	}
+
+private:
+	// each region writes its own slot of the stats, so no locking is needed
+	void recordRegion(FGExtractionStats* stats, TraceSink* trace, int i, int64 start, int64 end) const
+	{
+		const Rect& window = _windows[i];
+		if(stats){
+			RegionStats& regionStats = stats->regionStats[i];
+			regionStats.window = window;
+			regionStats.ms = ticksToMs(end - start);
+			regionStats.thread = currentThreadId();
+			regionStats.computed = true;
+		}
+		if(trace){
+			trace->complete("region", "region", start, end,
+							format("\"index\": %d, \"x\": %d, \"y\": %d, \"width\": %d, \"height\": %d",
+								   i, window.x, window.y, window.width, window.height));
+		}
+	}
+
+	FGExtraction* _fgExtraction;
+	const Mat& _inImg;
+	const vector<RotatedRect>& _orientedBoxes;
+	vector<Rect>& _windows;
+	vector<BitMask>& _regionMasks;
+	const vector<uchar>* _recompute;
+};
+
+//********** class BatchScheduler ************************************************
+
+// Runs a batch of frames on a work-stealing pool. Each frame in flight owns an
+// engine, a copy of the settings with a workspace of its own. A frame task
+// localizes the objects and spawns one task per local region; the region that
+// finishes last merges the masks, completes the frame and starts the next one.
+// A frame whose stages throw, e.g. on an unsupported depth, completes with an
+// empty mask like an unreadable one, and the batch goes on. A reader that
+// throws ends the batch after that frame, which fails; a completion callback
+// that throws leaves the frame's mask slot empty
+class BatchScheduler
+{
+public:
+	BatchScheduler(const FGExtraction& settings, const FGExtraction::FrameReader& next,
+				   const FGExtraction::FrameCallback& onFrameDone, vector<Mat>* fgImgs, int threads)
+		: _pool(threads), _next(next), _onFrameDone(onFrameDone), _fgImgs(fgImgs),
+		  _frameCount(0), _exhausted(false)
+	{
+		// one frame per thread keeps the threads busy while frames are localized
+		for(int i = 0; i < _pool.threadCount(); ++i){
+			FGExtraction* engine = settings.clone();
+			engine->_ws = FGExtraction::Workspace();
+			engine->_temporalMode = false;
+			engine->resetTemporalState();
+			engine->clearFrameCache();
+			engine->_stats = NULL;
+			engine->_allocCount = 0;
+			_engines.push_back(engine);
+		}
+		_idleEngines = _engines;
+	}
+
+	~BatchScheduler()
+	{
+		for(size_t i = 0; i < _engines.size(); ++i)
+			delete _engines[i];
+	}
+
+	// returns : number of workspace buffers the engines allocated
+	int run()
+	{
+		startFrames();
+		_pool.wait();
+
+		int allocCount = 0;
+		for(size_t i = 0; i < _engines.size(); ++i)
+			allocCount += _engines[i]->_allocCount;
+		return allocCount;
+	}
+
+private:
+	struct Frame
+	{
+		size_t					index;
+		Mat						inImg;
+		FGExtraction*			engine;
+		vector<RotatedRect>		orientedBoxes;
+		bool					noObjects;	// failed the empty frame check
+		std::atomic<bool>		failed;		// a stage threw
+		std::atomic<int>		remaining;	// regions still running
+	};
+
+	// hands frames to idle engines until either runs out
+	void startFrames()
+	{
+		for(;;){
+			Frame* frame;
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if(_exhausted || _idleEngines.empty())
+					return;
+				Mat inImg;
+				bool failed = false;
+				try{
+					if(!_next(inImg)){
+						_exhausted = true;
+						return;
+					}
+				}
+				catch(const std::exception&){
+					// where the reader stands is unknown, so it is not called again
+					inImg.release();
+					failed = true;
+					_exhausted = true;
+				}
+				frame = new Frame;
+				frame->inImg = inImg;
+				frame->index = _frameCount++;
+				frame->noObjects = false;
+				frame->failed = failed;
+				frame->engine = _idleEngines.back();
+				_idleEngines.pop_back();
+			}
+			_pool.submit([this, frame]() { localizeFrame(frame); });
+		}
+	}
+
+	void localizeFrame(Frame* frame)
+	{
+		// an unreadable frame completes with an empty mask
+		FGExtraction& engine = *frame->engine;
+		if(frame->inImg.empty()){
+			finishFrame(frame);
+			return;
+		}
+		int n = 0;
+		try{
+			frame->inImg = engine.grayInput(frame->inImg);
+			frame->noObjects = engine._emptyFrameCheck && !engine.mayContainObjects(frame->inImg);
+			if(!frame->noObjects){
+				engine.workBuffer(engine._ws.fgImg, frame->inImg.size(), CV_8U);
+				vector<vector<Point>> contours;
+				engine.coarseLocalize(frame->inImg, contours);
+				orientedBoundingBoxes(contours, frame->orientedBoxes, engine._ws.contourPoints);
+
+				n = (int)contours.size();
+				engine._ws.windows.resize(n);
+				engine._ws.regionMasks.resize(n);
+				if((int)engine._ws.regions.size() < n)
+					engine._ws.regions.resize(n);
+			}
+		}
+		catch(const std::exception&){
+			// cv::Exception included
+			frame->failed = true;
+		}
+		if(n == 0){
+			finishFrame(frame);
+			return;
+		}
+
+		// regions go to this thread's deque, idle threads steal them from there
+		frame->remaining = n;
+		for(int i = 0; i < n; ++i)
+			_pool.submit([this, frame, i]() { segmentRegion(frame, i); });
+	}
+
+	void segmentRegion(Frame* frame, int i)
+	{
+		FGExtraction& engine = *frame->engine;
+		FGExtraction::Workspace& ws = engine._ws;
+		try{
+			engine.segmentLocalRegion(frame->inImg, frame->orientedBoxes[i], ws.windows[i], ws.regionMasks[i], ws.regions[i]);
+		}
+		catch(const std::exception&){
+			frame->failed = true;
+		}
+		if(--frame->remaining == 0)
+			finishFrame(frame);
+	}
+
+	void finishFrame(Frame* frame)
+	{
+		FGExtraction& engine = *frame->engine;
+		FGExtraction::Workspace& ws = engine._ws;
+
+		// every frame has its own output slot, so no lock is needed
+		Mat localImg;
+		Mat& outImg = _fgImgs ? (*_fgImgs)[frame->index] : localImg;
+		if(frame->inImg.empty() || frame->failed){
+			outImg.release();
+		}
+		else if(frame->noObjects){
+			outImg.create(frame->inImg.size(), CV_8U);
+			outImg.setTo(0);
+		}
+		else{
+			try{
+				engine.mergeLocalRegions(ws.windows, ws.regionMasks, ws.fgImg);
+				engine.finishForeground(frame->inImg, ws.fgImg, outImg);
+			}
+			catch(const std::exception&){
+				outImg.release();
+			}
+		}
+		if(_onFrameDone){
+			try{
+				_onFrameDone(frame->index, outImg);
+			}
+			catch(const std::exception&){
+				// the engine still has to go back to the idle list
+				outImg.release();
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_idleEngines.push_back(frame->engine);
+		}
+		delete frame;
+		startFrames();
+	}
+
+	WorkStealingPool						_pool;
+	const FGExtraction::FrameReader&		_next;
+	const FGExtraction::FrameCallback&		_onFrameDone;
+	vector<Mat>*							_fgImgs;
+	vector<FGExtraction*>					_engines;
+	vector<FGExtraction*>					_idleEngines;
+	std::mutex								_mutex;		// guards _next, _idleEngines and _frameCount
+	size_t									_frameCount;
+	bool									_exhausted;
+};
 
 //********** class FGExtraction **************************************************
 
+// gradient a pixel needs to count as an edge in coarse localization
+static const int gradientThreshold = 20;
+
+// Otsu threshold of a histogram; cumulative counts and moments make every
+// candidate threshold O(1)
+//     h         - bin counts
+//     nbins     - number of bins
+//     lowerVal  - lower bound of bin index
+//     upperVal  - upper bound of bin index
+//     u1Ptr     - pointer to receive the mean of lower class
+//
+//     returns : Otsu threshold value (bin index)
+//
+template<typename T>
+static int otsuThreshold(const T* h, int nbins, int lowerVal, int upperVal, int* u1Ptr)
+{
+	if(nbins == 0) return -1;
+	lowerVal = std::max(lowerVal, 0);
+	upperVal = std::min(upperVal, nbins - 1);
+
+	double size = 0;
+	for (int j = 0; j < nbins; ++j)
+		size += h[j];
+
+	// count and first moment of the whole [lowerVal, upperVal] range
+	double rangeCount = 0, rangeMoment = 0;
+	for (int j = lowerVal; j <= upperVal; ++j){
+		rangeCount += h[j];
+		rangeMoment += j*(double)h[j];
+	}
+
+	// lower class is [lowerVal, i-1], upper class is [i, upperVal]
+	double lowCount = 0, lowMoment = 0;
+	double max = -1;
+	int index = 1;
+	double u1max = -1;
+
+	for (int i = lowerVal+1; i < upperVal; ++i){
+		lowCount += h[i-1];
+		lowMoment += (i-1)*(double)h[i-1];
+
+		double w1 = lowCount / size;
+		double w2 = 1 - w1;
+		double u1 = lowMoment / lowCount;
+		double u2 = (rangeMoment - lowMoment) / (rangeCount - lowCount);
+
+		// strict comparison keeps the first maximum, as before
+		double between = w1 * w2 * (u1-u2) * (u1-u2);
+		if (between > max){
+			max = between;
+			index = i;
+			u1max = u1;
+		}
+	}
+	
+	if(u1Ptr)
+		*u1Ptr = (int)(u1max + 0.5);
+	return index;
+}
+
+// Gray level mean and sample variance of the pixels of a region
+//     inImg  - input grayscale image
+//     region - region in inImg coordinates
+//
+static void regionMeanVar(const Mat& inImg, const RLERegion& region, double& mean, double& var)
+{
+	// pixel count, sum and sum of squares
+	int64 n = region.area();
+	int64 sum = 0, sumSq = 0;
+	region.forEachRun([&](int y, int x0, int x1) {
+		const uchar* inRow = inImg.ptr<uchar>(y);
+		for(int x = x0; x < x1; ++x){
+			int px = inRow[x];
+			sum += px;
+			sumSq += px*px;
+		}
+	});
+
+	// SSD = sumSq - sum^2/n, split as sum = q*n + r to stay exact in int64
+	mean = n ? double(sum) / double(n) : 0;
+	var = 0;
+	if(n > 1){
+		int64 q = sum / n;
+		int64 r = sum - q*n;
+		double SSD = double(sumSq - q*q*n - 2*q*r) - double(r)*double(r)/double(n);
+		var = SSD / double(n-1);
+	}
+}
+
 FGExtraction::FGExtraction(double minArea, double maxArea, double minVar, 
                            double pHigh, double pLow,
                            double theta, int nbins,
@@ -18,9 +403,15 @@ FGExtraction::FGExtraction(double minArea, double maxArea, double minVar,
 	: _minArea(minArea), _maxArea(maxArea), _minVar(minVar),
       _pHigh(pHigh), _pLow(pLow),
       _theta(theta), _binCount(nbins),
-	  _gradSESize(gradSESize), _areaSESize(areaSESize), _postSESize(postSESize)
+	  _gradSESize(gradSESize), _areaSESize(areaSESize), _postSESize(postSESize),
+	  _regionLocal(true), _parallelRegions(true), _fastMorphology(true), _fusedRegions(true),
+	  _pyramidLevel(0), _pyrGradSESize(gradSESize),
+	  _temporalMode(false), _tileSize(64), _changeTol(8), _refreshInterval(30),
+	  _emptyFrameCheck(true), _frameCacheCapacity(0), _frameCacheTol(0),
+	  _allocCount(0), _stats(NULL), _trace(NULL)
 {
-	
+	updateTables();
+	resetTemporalState();
 }
 
 FGExtraction::~FGExtraction()
@@ -28,68 +419,399 @@ FGExtraction::~FGExtraction()
 
 }
 
+// Replaces the parameters of the constructor, keeping all other settings
+void FGExtraction::setParameters(double minArea, double maxArea, double minVar, double pHigh, double pLow,
+								 double theta, int nbins, int gradSESize, int areaSESize, int postSESize)
+{
+	_minArea = minArea;
+	_maxArea = maxArea;
+	_minVar = minVar;
+	_pHigh = pHigh;
+	_pLow = pLow;
+	_theta = theta;
+	_binCount = nbins;
+	_gradSESize = gradSESize;
+	_areaSESize = areaSESize;
+	_postSESize = postSESize;
+	updateTables();
+	resetTemporalState();
+	clearFrameCache();
+}
+
+// Derives the SE spans and the bin table from the parameters
+void FGExtraction::updateTables()
+{
+	ellipseSpans(_gradSESize, _gradSpans);
+	ellipseSpans(_areaSESize, _areaSpans);
+	ellipseSpans(_postSESize, _postSpans);
+	setPyramidLevel(_pyramidLevel);
+
+	// same bins as calcHist with the uniform range [0, 255)
+	_binIndex.resize(256);
+	for(int i = 0; i < 256; ++i)
+		_binIndex[i] = std::min(cvFloor(i * (double(_binCount) / 255.0)), _binCount);
+}
+
+// Returns a copy of this instance with the same settings and the dynamic type
+// of this instance, e.g. one batch engine per frame
+FGExtraction* FGExtraction::clone() const
+{
+	return new FGExtraction(*this);
+}
+
 // Extract foreground objects (i.e. segmentation) from input image
-//     src - input image
-//     dst - output image, binary object mask
+//     src   - input image
+//     dst   - output image, binary object mask
+//     stats - if not NULL, receives the stage timings and work counters
+//
+void FGExtraction::extractForeground(InputArray src, OutputArray dst, FGExtractionStats* stats) 
+{
+	segmentFrame(src, dst, NULL, stats);
+}
+
+// same as above, also returning the final objects
+//     objects - receives the mask pixels inside each object's outer contour as runs
 //
-void FGExtraction::extractForeground(InputArray src, OutputArray dst) 
+void FGExtraction::extractForeground(InputArray src, OutputArray dst, vector<RLERegion>& objects, FGExtractionStats* stats)
+{
+	vector<SegmentedObject> segmented;
+	segmentFrame(src, dst, &segmented, stats);
+	objects.resize(segmented.size());
+	for(size_t i = 0; i < segmented.size(); ++i)
+		std::swap(objects[i], segmented[i].region);
+}
+
+// Extracts the objects of a frame as a list instead of a mask
+//     src     - input image
+//     objects - receives the runs, boxes, area and gray level statistics of each object
+//     dst     - if given, receives the binary object mask as well
+//     stats   - if not NULL, receives the stage timings and work counters
+//
+void FGExtraction::extractObjects(InputArray src, vector<SegmentedObject>& objects, OutputArray dst,
+								  FGExtractionStats* stats)
+{
+	objects.clear();
+	if(dst.needed()){
+		segmentFrame(src, dst, &objects, stats);
+	}
+	else{
+		Mat fgImg;
+		segmentFrame(src, fgImg, &objects, stats);
+	}
+}
+
+// Segments one frame, see extractForeground
+void FGExtraction::segmentFrame(InputArray src, OutputArray dst, vector<SegmentedObject>* objects, FGExtractionStats* stats)
 {
 	if(!src.obj) return;
-	Mat inImg = src.getMat().clone();
-	dst.create(inImg.size(), CV_8U);
-	Mat outImg = dst.getMat();
+	Mat inImg = src.getMat();
+
+	_stats = stats;
+	if(_stats)
+		_stats->reset();
+	int64 callStart = (_stats || _trace) ? getTickCount() : 0;
 	
     // convert input image to grayscale if it is color
-	if(inImg.channels() > 1)
-		cvtColor(inImg, inImg, COLOR_BGR2GRAY);
+	inImg = grayInput(inImg);
 	
-    // coarse object localization using morphological gradient
-	Mat gradImg;
-	Mat se = getStructuringElement(MORPH_ELLIPSE, Size(_gradSESize, _gradSESize));
-	morphologyEx(inImg, gradImg, MORPH_GRADIENT, se);
-	threshold(gradImg, gradImg, 20, 255, THRESH_BINARY);
+	// frames without objects and repeated frames skip the segmentation
+	bool useCache = _frameCacheCapacity > 0 && !_temporalMode;
+	uint64 signature = 0;
+	if(!_temporalMode && _emptyFrameCheck && !mayContainObjects(inImg)){
+		dst.create(inImg.size(), CV_8U);
+		dst.getMat().setTo(0);
+		if(_stats)
+			_stats->emptyFrame = true;
+	}
+	else if(useCache && lookupFrameCache(inImg, signature = frameSignature(inImg), dst, objects)){
+		if(_stats)
+			_stats->cacheHit = true;
+	}
+	else{
+		segmentObjects(inImg, dst, objects);
+		if(useCache)
+			storeFrameCache(inImg, signature, dst.getMat(), objects);
+	}
 
-	vector<vector<Point>> contours = extractContours(gradImg);
-	for (size_t i = 0; i < contours.size(); i++){
-		double area = contourArea(contours[i]);
-		if(area < _minArea || area > _maxArea){
-			drawContours(gradImg, contours, i, Scalar(0), -1);
+	if(_stats || _trace){
+		int64 callEnd = getTickCount();
+		if(_stats)
+			_stats->totalMs = ticksToMs(callEnd - callStart);
+		if(_trace)
+			_trace->complete("extractForeground", "frame", callStart, callEnd,
+							 format("\"width\": %d, \"height\": %d", inImg.cols, inImg.rows));
+	}
+	_stats = NULL;
+	return;
+}
+
+// Segments the objects of a grayscale frame, the part of segmentFrame the
+// shortcuts skip
+//     inImg   - input grayscale image
+//     dst     - output image, binary object mask
+//     objects - if not NULL, receives the runs of each object
+//
+void FGExtraction::segmentObjects(const Mat& inImg, OutputArray dst, vector<SegmentedObject>* objects)
+{
+    // for each object, apply double local thresholding and then histogram backprojection
+	Mat& fgImg = workBuffer(_ws.fgImg, inImg.size(), CV_8U);
+	fgImg.setTo(0);
+	if(_temporalMode){
+		segmentIncremental(inImg, fgImg);
+	}
+	else{
+		// coarse object localization using morphological gradient
+		vector<vector<Point>> contours;
+		coarseLocalize(inImg, contours);
+		vector<RotatedRect>& orientedBoxes = _ws.orientedBoxes;
+		orientedBoundingBoxes(contours, orientedBoxes, _ws.contourPoints);
+
+		if(_regionLocal){
+			// regions only read inImg, so they can be segmented independently
+			_ws.windows.resize(contours.size());
+			_ws.regionMasks.resize(contours.size());
+			segmentLocalRegions(inImg, orientedBoxes, _ws.windows, _ws.regionMasks, NULL);
+			mergeLocalRegions(_ws.windows, _ws.regionMasks, fgImg);
+		}
+		else{
+			StageScope scope(_stats, _trace, FGExtractionStats::STAGE_REGIONS, contours.size() * inImg.total());
+			if(_ws.regions.empty())
+				_ws.regions.resize(1);
+			RegionWorkspace& ws = _ws.regions[0];
+			Mat& mask = workBuffer(_ws.maskImg, inImg.size(), CV_8U);
+			mask.setTo(0);
+			for(size_t i = 0; i < contours.size(); ++i)
+			{
+				// create the "local region" mask
+				RotatedRect orientedBox = orientedBoxes[i];
+				orientedBox.size.width *= 1.5;
+				orientedBox.size.height *= 1.5;
+				ellipse(mask, orientedBox, Scalar(255), -1);
+				
+				// double local thresholding
+				Mat fgHighRaw = ws.highRaw.get(inImg.size(), CV_8U, &_allocCount);
+				Mat fgLowRaw = ws.lowRaw.get(inImg.size(), CV_8U, &_allocCount);
+				doubleLocalThreshold(inImg, fgHighRaw, fgLowRaw, mask, &ws.levelCounts);
+
+				// remove noise by a median filter
+				Mat fgHighImg = ws.highImg.get(inImg.size(), CV_8U, &_allocCount);
+				Mat fgLowImg = ws.lowImg.get(inImg.size(), CV_8U, &_allocCount);
+				medianFilter(fgHighRaw, fgHighImg);
+				medianFilter(fgLowRaw, fgLowImg);
+				
+				// merge two masks using histogram backprojection
+				updateByHistBackproject(inImg, fgHighImg, fgLowImg, fgImg, mask, ws);
+
+				// remove the used local region from mask
+				ellipse(mask, orientedBox, Scalar(0), -1);
+			}
 		}
 	}
 
+	finishForeground(inImg, fgImg, dst, objects);
+}
 
-	// get object contours from coarse localization
-	contours.clear();
-	contours = extractContours(gradImg);
-    
-    // for each object, apply double local thresholding and then histogram backprojection
-	Mat fgImg = Mat::zeros(gradImg.size(), CV_8U); 
-	Mat mask = Mat::zeros(gradImg.size(), CV_8U); 
-	for(size_t i = 0; i < contours.size(); ++i)
-	{
-		// create the "local region" mask
-        Rect uprightBox = boundingRect(contours[i]);
-		RotatedRect orientedBox = orientedBoundingBox(contours[i]);
-		orientedBox.size.width *= 1.5;
-        orientedBox.size.height *= 1.5;
-		ellipse(mask, orientedBox, Scalar(255), -1);
-		
-		// double local thresholding
-		Mat fgHighImg, fgLowImg;
-		doubleLocalThreshold(inImg, fgHighImg, fgLowImg, mask);
-
-		// remove noise by a median filter
-		medianBlur(fgHighImg, fgHighImg, 3);
-		medianBlur(fgLowImg, fgLowImg, 3);
-		
-		// merge two masks using histogram backprojection
-		updateByHistBackproject(inImg, fgHighImg, fgLowImg, fgImg, mask);
-
-		// remove the used local region from mask
-		ellipse(mask, orientedBox, Scalar(0), -1);
+// Tells whether a frame may hold an object, from the gray level range of
+// 16x16 blocks: a pixel's gradient is at most the range of the blocks its SE
+// reaches, and at a pyramid level the smoothed values stay within the range
+// of the pixels they are made of. Every edge pixel thus lies in a block whose
+// neighbourhood range exceeds the gradient threshold, and each gradient
+// region lies in the bounding box of one 8-connected component of those blocks
+//     inImg - input grayscale image
+//
+//     returns : false only if no gradient region can reach the minimum area
+//
+bool FGExtraction::mayContainObjects(const Mat& inImg)
+{
+	const int blockSize = 16;
+	int blocksX = (inImg.cols + blockSize - 1) / blockSize;
+	int blocksY = (inImg.rows + blockSize - 1) / blockSize;
+	if(blocksX == 0 || blocksY == 0)
+		return false;
+
+	Mat blockMin(blocksY, blocksX, CV_8U, Scalar(255));
+	Mat blockMax(blocksY, blocksX, CV_8U, Scalar(0));
+	for(int y = 0; y < inImg.rows; ++y){
+		const uchar* in = inImg.ptr<uchar>(y);
+		uchar* minRow = blockMin.ptr<uchar>(y / blockSize);
+		uchar* maxRow = blockMax.ptr<uchar>(y / blockSize);
+		for(int bx = 0; bx < blocksX; ++bx){
+			int x0 = bx * blockSize;
+			int x1 = std::min(x0 + blockSize, inImg.cols);
+			uchar lo = minRow[bx], hi = maxRow[bx];
+			for(int x = x0; x < x1; ++x){
+				lo = std::min(lo, in[x]);
+				hi = std::max(hi, in[x]);
+			}
+			minRow[bx] = lo;
+			maxRow[bx] = hi;
+		}
 	}
 
-	
+	// reach of the gradient SE, plus the pyrDown kernels at a pyramid level
+	int scale = 1 << _pyramidLevel;
+	int reach = _pyramidLevel ? scale * (_pyrGradSESize/2 + 2) + 2 : _gradSESize/2;
+	int blockReach = (reach + blockSize - 1) / blockSize;
+	Mat se = getStructuringElement(MORPH_RECT, Size(2*blockReach + 1, 2*blockReach + 1));
+	dilate(blockMax, blockMax, se);
+	erode(blockMin, blockMin, se);
+
+	// map of the active blocks with a blank border, which findContours needs
+	Mat active(blocksY + 2, blocksX + 2, CV_8U, Scalar(0));
+	for(int by = 0; by < blocksY; ++by){
+		const uchar* minRow = blockMin.ptr<uchar>(by);
+		const uchar* maxRow = blockMax.ptr<uchar>(by);
+		uchar* activeRow = active.ptr<uchar>(by + 1) + 1;
+		for(int bx = 0; bx < blocksX; ++bx)
+			activeRow[bx] = maxRow[bx] - minRow[bx] > gradientThreshold ? 255 : 0;
+	}
+	vector<vector<Point>> components;
+	findContours(active, components, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE, Point(-1, -1));
+
+	// a contour encloses no more than the box of its points; at a pyramid
+	// level the box shrinks by the scale, plus a pixel of rounding per side
+	for(size_t i = 0; i < components.size(); ++i){
+		Rect box = boundingRect(components[i]);
+		double width = std::min(box.br().x * blockSize, inImg.cols) - box.x * blockSize;
+		double height = std::min(box.br().y * blockSize, inImg.rows) - box.y * blockSize;
+		double levelArea = (width / scale + 2) * (height / scale + 2);
+		if(levelArea >= _minArea / (scale*scale))
+			return true;
+	}
+	return false;
+}
+
+// Sets up the frame cache, see setFrameCache in the header
+//     capacity  - number of frames kept, 0 to turn the cache off
+//     tolerance - largest gray level difference of a matching frame
+//
+void FGExtraction::setFrameCache(int capacity, int tolerance)
+{
+	_frameCacheCapacity = std::max(capacity, 0);
+	_frameCacheTol = std::max(tolerance, 0);
+	clearFrameCache();
+}
+
+// Hash of a coarse thumbnail of a frame: 8x8 block means at 16 gray levels,
+// so that frames differing by noise mostly share the signature; matches are
+// confirmed pixel by pixel in lookupFrameCache
+//
+uint64 FGExtraction::frameSignature(const Mat& inImg)
+{
+	Mat thumb;
+	resize(inImg, thumb, Size(8, 8), 0, 0, INTER_AREA);
+
+	// FNV-1a over the frame size and the quantized thumbnail
+	uint64 hash = 14695981039346656037ULL;
+	hash = (hash ^ (uint64)inImg.cols) * 1099511628211ULL;
+	hash = (hash ^ (uint64)inImg.rows) * 1099511628211ULL;
+	for(int y = 0; y < thumb.rows; ++y){
+		const uchar* row = thumb.ptr<uchar>(y);
+		for(int x = 0; x < thumb.cols; ++x)
+			hash = (hash ^ (row[x] >> 4)) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+// Answers a frame from the cache
+//     inImg     - input grayscale image
+//     signature - frameSignature of inImg
+//     dst       - receives the cached mask on a hit
+//     objects   - if not NULL, receives the cached objects on a hit
+//
+//     returns : true on a hit
+//
+bool FGExtraction::lookupFrameCache(const Mat& inImg, uint64 signature, OutputArray dst, vector<SegmentedObject>* objects)
+{
+	for(size_t i = 0; i < _frameCache.size(); ++i){
+		CachedFrame& entry = _frameCache[i];
+		if(entry.signature != signature || entry.inImg.size() != inImg.size() || (objects && !entry.hasObjects))
+			continue;
+		if(norm(inImg, entry.inImg, NORM_INF) > _frameCacheTol)
+			continue;
+
+		entry.fgImg.copyTo(dst);
+		if(objects)
+			*objects = entry.objects;
+
+		// move the entry to the front
+		std::rotate(_frameCache.begin(), _frameCache.begin() + i, _frameCache.begin() + i + 1);
+		return true;
+	}
+	return false;
+}
+
+// Adds a segmented frame to the cache, dropping the least recently used one
+// if it is full
+//
+void FGExtraction::storeFrameCache(const Mat& inImg, uint64 signature, const Mat& fgImg,
+								   const vector<SegmentedObject>* objects)
+{
+	if((int)_frameCache.size() == _frameCacheCapacity)
+		_frameCache.pop_back();
+
+	CachedFrame entry;
+	entry.signature = signature;
+	entry.inImg = inImg.clone();
+	entry.fgImg = fgImg.clone();
+	entry.hasObjects = objects != NULL;
+	if(objects)
+		entry.objects = *objects;
+	_frameCache.insert(_frameCache.begin(), entry);
+}
+
+// Segments a batch of independent frames
+//     inImgs      - input images
+//     fgImgs      - output images, binary object masks in the order of inImgs
+//     onFrameDone - if set, called with each mask as soon as it is done
+//     threads     - number of worker threads, 0 for one per hardware thread
+//
+void FGExtraction::extractForegroundBatch(const vector<Mat>& inImgs, vector<Mat>& fgImgs,
+										  const FrameCallback& onFrameDone, int threads)
+{
+	fgImgs.resize(inImgs.size());
+	size_t i = 0;
+	FrameReader next = [&inImgs, &i](Mat& inImg) -> bool {
+		if(i == inImgs.size())
+			return false;
+		inImg = inImgs[i++];
+		return true;
+	};
+	runBatch(next, onFrameDone, &fgImgs, threads);
+}
+
+// Runs a batch on a work-stealing pool, see BatchScheduler
+//     next        - reads the next frame, called under a lock
+//     onFrameDone - completion callback, may be empty
+//     fgImgs      - if not NULL, receives the masks, one slot per frame
+//     threads     - number of worker threads, 0 for one per hardware thread
+//
+void FGExtraction::runBatch(const FrameReader& next, const FrameCallback& onFrameDone, vector<Mat>* fgImgs, int threads)
+{
+	BatchScheduler scheduler(*this, next, onFrameDone, fgImgs, threads);
+	_allocCount += scheduler.run();
+}
+
+// Returns the input as grayscale, converted in the workspace if it is color;
+// the input is only read, dst is written at the very end, so no copy is needed
+//
+Mat FGExtraction::grayInput(const Mat& inImg)
+{
+	if(inImg.channels() == 1)
+		return inImg;
+	StageScope scope(_stats, _trace, FGExtractionStats::STAGE_GRAYSCALE, inImg.total());
+	cvtColor(inImg, workBuffer(_ws.grayImg, inImg.size(), CV_8U), COLOR_BGR2GRAY);
+	return _ws.grayImg;
+}
+
+// Final stages of a frame once the local regions are merged
+//     inImg   - input grayscale image
+//     fgImg   - merged object mask, refined in place
+//     dst     - output image, binary object mask
+//     objects - if not NULL, receives the runs of each remaining object
+//
+void FGExtraction::finishForeground(const Mat& inImg, Mat& fgImg, OutputArray dst, vector<SegmentedObject>* objects)
+{
     // thresholding by area and variance
 	thresholdByAreaVar(inImg, fgImg, fgImg);
 
@@ -97,26 +819,487 @@ void FGExtraction::extractForeground(InputArray src, OutputArray dst)
     postProcessing(fgImg, fgImg);
 	
     // discard connected components with small or large area
-	contours.clear();
-	contours = extractContours(fgImg);
-	for (size_t i = 0; i < contours.size(); i++){
-		double area = contourArea(contours[i]);
-		if(area < _minArea || area > _maxArea){
-			drawOneContour(fgImg, contours[i], Scalar(0), -1);
+	{
+		StageScope scope(_stats, _trace, FGExtractionStats::STAGE_FINAL_AREA, fgImg.total());
+		vector<vector<Point>> contours = extractContours(fgImg, _ws.contourImg);
+		vector<vector<Point>> objectContours;
+		RLERegion& target = _ws.targetRegion;
+		for (size_t i = 0; i < contours.size(); i++){
+			double area = contourArea(contours[i]);
+			bool reject = area < _minArea || area > _maxArea;
+			if(!reject && !objects)
+				continue;
+
+			// clearing the filled contour also clears whatever lies in its holes
+			target.fromContour(contours[i], _ws.targetWindow, &_allocCount);
+			if(reject){
+				target.fill(fgImg, 0);
+			}
+			else{
+				Rect box = target.boundingRect();
+				_ws.maskRegion.fromMask(fgImg(box), box.tl());
+				objects->push_back(SegmentedObject());
+				objects->back().region = target.intersect(_ws.maskRegion);
+				objectContours.push_back(vector<Point>());
+				objectContours.back().swap(contours[i]);
+			}
+		}
+
+		// boxes and gray level statistics of the kept objects
+		if(objects){
+			vector<RotatedRect>& orientedBoxes = _ws.orientedBoxes;
+			orientedBoundingBoxes(objectContours, orientedBoxes, _ws.contourPoints);
+			for(size_t i = 0; i < objects->size(); ++i){
+				SegmentedObject& object = (*objects)[i];
+				object.boundingBox = object.region.boundingRect();
+				object.area = object.region.area();
+				regionMeanVar(inImg, object.region, object.mean, object.variance);
+				object.orientedBox = orientedBoxes[i];
+			}
 		}
 	}
 	
+	dst.create(inImg.size(), CV_8U);
+	Mat outImg = dst.getMat();
 	fgImg.copyTo(outImg);
-	return;
+}
+
+// Returns a workspace buffer of the given geometry, reallocating it only if
+// the geometry differs from the previous call
+//
+Mat& FGExtraction::workBuffer(Mat& buf, Size size, int type)
+{
+	if(buf.size() != size || buf.type() != type){
+		buf.create(size, type);
+		CV_XADD(&_allocCount, 1);
+	}
+	return buf;
+}
+
+// Enables or disables temporal incremental segmentation
+//     enable          - turn the mode on or off
+//     tileSize        - side length of the change detection tiles
+//     changeTol       - a tile changes when any pixel moves by more than this
+//     refreshInterval - every refreshInterval-th frame is segmented from scratch
+//
+void FGExtraction::setTemporalMode(bool enable, int tileSize, int changeTol, int refreshInterval)
+{
+	_temporalMode = enable;
+	_tileSize = std::max(tileSize, 8);
+	_changeTol = std::max(changeTol, 0);
+	_refreshInterval = std::max(refreshInterval, 1);
+	resetTemporalState();
+}
+
+// Forgets the previous frame, e.g. at the start of a new stream
+void FGExtraction::resetTemporalState()
+{
+	_state.frameCount = 0;
+	_state.refImg.release();
+	_state.gradImg.release();
+	_state.contours.clear();
+	_state.windows.clear();
+	_state.regionMasks.clear();
+}
+
+// Selects the pyramid level of coarse localization
+//     level - 0 for full resolution, up to 4 (1/16 scale)
+//
+void FGExtraction::setPyramidLevel(int level)
+{
+	_pyramidLevel = std::min(std::max(level, 0), 4);
+
+	// the gradient SE shrinks with the frame but stays odd and at least 3x3
+	int scale = 1 << _pyramidLevel;
+	_pyrGradSESize = _pyramidLevel ? std::max(3, cvRound(double(_gradSESize) / scale) | 1) : _gradSESize;
+	ellipseSpans(_pyrGradSESize, _pyrGradSpans);
+	clearFrameCache();
+}
+
+// Computes the halo of a tile for tiled segmentation
+//     maxObjectSize - largest extent of an object, in pixels
+//
+//     returns : halo width in pixels
+//
+int FGExtraction::tileHalo(int maxObjectSize) const
+{
+	// an object touching the core lies within maxObjectSize of it, and its
+	// 1.5x ellipse reaches 0.75 box sides from the box center
+	int regionReach = cvCeil(1.75 * maxObjectSize);
+
+	// border effects of the filters: gradient, area closing, the six passes
+	// of post-processing and the median filter
+	int filterReach = _gradSESize/2 + 2*(_areaSESize/2) + 6*(_postSESize/2) + 1;
+	if(_pyramidLevel > 0)
+		filterReach += (1 << _pyramidLevel) * (_pyrGradSESize/2 + 3);
+	return regionReach + filterReach;
+}
+
+// Coarse object localization at the selected pyramid level
+//     inImg    - input grayscale image
+//     contours - object contours, in full resolution coordinates
+//
+void FGExtraction::coarseLocalize(const Mat& inImg, vector<vector<Point>>& contours)
+{
+	if(_pyramidLevel == 0){
+		Mat& gradImg = workBuffer(_ws.gradImg, inImg.size(), CV_8U);
+		coarseGradient(inImg, gradImg);
+		localizeObjects(gradImg, contours);
+		return;
+	}
+
+	// downscale by 2 per level
+	_ws.pyramid.resize(_pyramidLevel);
+	const Mat* levelImg = &inImg;
+	for(int i = 0; i < _pyramidLevel; ++i){
+		Size size((levelImg->cols + 1) / 2, (levelImg->rows + 1) / 2);
+		Mat& downImg = workBuffer(_ws.pyramid[i], size, CV_8U);
+		pyrDown(*levelImg, downImg, size);
+		levelImg = &downImg;
+	}
+
+	int scale = 1 << _pyramidLevel;
+	Mat& gradImg = workBuffer(_ws.pyrGradImg, levelImg->size(), CV_8U);
+	coarseGradient(*levelImg, gradImg, _pyrGradSESize, _pyrGradSpans);
+	localizeObjects(gradImg, contours, 1.0 / (scale*scale));
+
+	// map every point to the center of its block at full resolution
+	int offset = (scale - 1) / 2;
+	for(size_t i = 0; i < contours.size(); ++i){
+		for(size_t j = 0; j < contours[i].size(); ++j){
+			Point& p = contours[i][j];
+			p.x = std::min(p.x*scale + offset, inImg.cols - 1);
+			p.y = std::min(p.y*scale + offset, inImg.rows - 1);
+		}
+	}
+}
+
+// Computes the thresholded morphological gradient for coarse localization
+//     inImg   - input grayscale image
+//     gradImg - binary mask of strong gradient
+//
+void FGExtraction::coarseGradient(const Mat& inImg, Mat& gradImg)
+{
+	coarseGradient(inImg, gradImg, _gradSESize, _gradSpans);
+}
+
+// same as above with another elliptical SE
+//     seSize - size of the SE
+//     spans  - spans of the same SE
+//
+void FGExtraction::coarseGradient(const Mat& inImg, Mat& gradImg, int seSize, const vector<MorphSpan>& spans)
+{
+	StageScope scope(_stats, _trace, FGExtractionStats::STAGE_GRADIENT, inImg.total());
+	if(_fastMorphology){
+		morphologyBySpans(inImg, gradImg, MORPH_GRADIENT, spans, &_ws.morph, &_allocCount);
+	}
+	else{
+		Mat se = getStructuringElement(MORPH_ELLIPSE, Size(seSize, seSize));
+		morphologyEx(inImg, gradImg, MORPH_GRADIENT, se);
+	}
+	threshold(gradImg, gradImg, gradientThreshold, 255, THRESH_BINARY);
+}
+
+// Keeps the gradient regions of valid area and returns their contours
+//     gradImg   - binary gradient mask, regions of invalid area are erased
+//     contours  - contours of the remaining regions
+//     areaScale - scale of the area limits, 1/4 per pyramid level
+//
+void FGExtraction::localizeObjects(Mat& gradImg, vector<vector<Point>>& contours, double areaScale)
+{
+	StageScope scope(_stats, _trace, FGExtractionStats::STAGE_LOCALIZATION, 2 * gradImg.total());
+	contours = extractContours(gradImg, _ws.contourImg);
+	if(_stats)
+		_stats->coarseContours = (int)contours.size();
+	double minArea = _minArea * areaScale;
+	double maxArea = _maxArea * areaScale;
+	for (size_t i = 0; i < contours.size(); i++){
+		double area = contourArea(contours[i]);
+		if(area < minArea || area > maxArea){
+			drawContours(gradImg, contours, i, Scalar(0), -1);
+		}
+	}
+
+	// get object contours from coarse localization
+	contours.clear();
+	contours = extractContours(gradImg, _ws.contourImg);
+	if(_stats)
+		_stats->regions = (int)contours.size();
+}
+
+// Segments the local regions of all objects
+//     inImg         - input grayscale image
+//     orientedBoxes - oriented boxes of the object contours from coarse localization
+//     windows     - receives the window of each local region
+//     regionMasks - receives the window-sized object mask of each region
+//     recompute   - if not NULL, only regions with a non-zero flag are processed
+//
+void FGExtraction::segmentLocalRegions(const Mat& inImg, const vector<RotatedRect>& orientedBoxes,
+									   vector<Rect>& windows, vector<BitMask>& regionMasks,
+									   const vector<uchar>* recompute)
+{
+	StageScope scope(_stats, _trace, FGExtractionStats::STAGE_REGIONS, 0);
+	int n = (int)orientedBoxes.size();
+	if((int)_ws.regions.size() < n)
+		_ws.regions.resize(n);
+	if(_stats)
+		_stats->regionStats.assign(n, RegionStats());
+
+	LocalRegionBody body(this, inImg, orientedBoxes, windows, regionMasks, recompute);
+	if(_parallelRegions)
+		parallel_for_(Range(0, n), body);
+	else
+		body(Range(0, n));
+
+	// regions reused in temporal mode keep computed == false
+	if(_stats){
+		for(int i = 0; i < n; ++i){
+			_stats->regionStats[i].window = windows[i];
+			if(_stats->regionStats[i].computed)
+				_stats->stagePixels[FGExtractionStats::STAGE_REGIONS] += windows[i].area();
+		}
+	}
+}
+
+// Writes the union of the per-region object masks to the frame mask
+// OR is order-independent, so the result does not depend on scheduling;
+// the regions are merged 64 pixels at a time in a bit mask, then unpacked once
+//
+void FGExtraction::mergeLocalRegions(const vector<Rect>& windows, const vector<BitMask>& regionMasks, Mat& fgImg)
+{
+	StageScope scope(_stats, _trace, FGExtractionStats::STAGE_MERGE, fgImg.total());
+	BitMask& fgBits = _ws.fgBits;
+	fgBits.create(fgImg.size(), &_allocCount);
+	for(size_t i = 0; i < regionMasks.size(); ++i){
+		if(regionMasks[i].empty())
+			continue;
+		fgBits.orAt(regionMasks[i], windows[i].tl());
+	}
+	fgBits.toMat(fgImg);
+}
+
+// Computes the local region of an object, i.e. its 1.5x oriented ellipse
+//     orientedBox - oriented bounding box of the object contour
+//     imgSize     - size of the frame
+//     regionBox  - receives the oriented box of the ellipse
+//
+//     returns : bounding window of the ellipse plus a 1-pixel halo for the
+//               median filter, clipped to the frame
+//
+Rect FGExtraction::localRegionWindow(const RotatedRect& orientedBox, Size imgSize, RotatedRect& regionBox)
+{
+	regionBox = orientedBox;
+	regionBox.size.width *= 1.5;
+	regionBox.size.height *= 1.5;
+
+	Rect window = ellipseBoundingRect(regionBox);
+	window.x -= 1;
+	window.y -= 1;
+	window.width += 2;
+	window.height += 2;
+	window &= Rect(0, 0, imgSize.width, imgSize.height);
+	return window;
+}
+
+// Segments one local region inside its bounding window
+//     inImg       - input grayscale image
+//     objectBox   - oriented bounding box of the object contour from coarse localization
+//     window      - receives the window of the local region in inImg
+//     regionMask  - receives the object mask of the region, window-sized
+//     ws          - scratch buffers of the region
+//
+void FGExtraction::segmentLocalRegion(const Mat& inImg, const RotatedRect& objectBox, Rect& window, BitMask& regionMask,
+									  RegionWorkspace& ws)
+{
+	RotatedRect orientedBox;
+	window = localRegionWindow(objectBox, inImg.size(), orientedBox);
+	if(window.area() == 0){
+		regionMask.create(Size());
+		return;
+	}
+
+	// create the "local region" mask in window coordinates
+	Size size = window.size();
+	Mat mask = ws.mask.get(size, CV_8U, &_allocCount);
+	mask.setTo(0);
+	RotatedRect localBox = orientedBox;
+	localBox.center.x -= window.x;
+	localBox.center.y -= window.y;
+	ellipse(mask, localBox, Scalar(255), -1);
+
+	Mat inROI = inImg(window);
+
+	// double local thresholding
+	Mat fgHighRaw = ws.highRaw.get(size, CV_8U, &_allocCount);
+	Mat fgLowRaw = ws.lowRaw.get(size, CV_8U, &_allocCount);
+	doubleLocalThreshold(inROI, fgHighRaw, fgLowRaw, mask, &ws.levelCounts);
+
+	// remove noise by a median filter
+	Mat fgHighImg = ws.highImg.get(size, CV_8U, &_allocCount);
+	Mat fgLowImg = ws.lowImg.get(size, CV_8U, &_allocCount);
+	medianFilter(fgHighRaw, fgHighImg);
+	medianFilter(fgLowRaw, fgLowImg);
+
+	// merge two masks using histogram backprojection
+	regionMask.create(size, &_allocCount);
+	ws.roiBits.fromMat(mask, &_allocCount);
+	if(_fusedRegions){
+		uchar lut[256];
+		ratioHistLUT(inROI, fgHighImg, fgLowImg, lut, ws);
+		orByLUT(inROI, lut, ws.roiBits, regionMask);
+	}
+	else{
+		updateByHistBackproject(inROI, fgHighImg, fgLowImg, regionMask, ws.roiBits, ws);
+	}
+}
+
+// 3x3 median filter of a thresholded mask, a majority vote in fast mode
+//     src - binary mask of 0 and 255
+//     dst - filtered mask, must not be src
+//
+void FGExtraction::medianFilter(const Mat& src, Mat& dst)
+{
+	if(_fastMorphology)
+		binaryMedian3x3(src, dst);
+	else
+		medianBlur(src, dst, 3);
+}
+
+// Region segmentation that reuses the results of the previous frame
+// only regions near tiles that changed since they were last processed are
+// localized and thresholded again
+//     inImg - input grayscale image
+//     fgImg - object mask before area/variance thresholding
+//
+void FGExtraction::segmentIncremental(const Mat& inImg, Mat& fgImg)
+{
+	bool refresh = _state.refImg.empty() || _state.refImg.size() != inImg.size()
+				|| _state.frameCount % _refreshInterval == 0;
+	++_state.frameCount;
+
+	int gradRadius = _gradSESize / 2;
+	vector<Rect> dirtyRects;
+	if(refresh){
+		inImg.copyTo(_state.refImg);
+		coarseGradient(inImg, _state.gradImg);
+	}
+	else{
+		vector<Rect> changedRects;
+		findChangedTiles(inImg, changedRects);
+
+		// nothing moved, the previous regions are still valid
+		if(changedRects.empty()){
+			mergeLocalRegions(_state.windows, _state.regionMasks, fgImg);
+			return;
+		}
+
+		// refresh the gradient wherever its SE reaches a changed tile;
+		// it is computed on a window with another SE radius so the border is exact
+		Rect frameRect(0, 0, inImg.cols, inImg.rows);
+		for(size_t i = 0; i < changedRects.size(); ++i){
+			inImg(changedRects[i]).copyTo(_state.refImg(changedRects[i]));
+
+			Rect inner = expandRect(changedRects[i], gradRadius) & frameRect;
+			Rect outer = expandRect(inner, gradRadius) & frameRect;
+			Mat gradOuter;
+			coarseGradient(inImg(outer), gradOuter);
+			gradOuter(inner - outer.tl()).copyTo(_state.gradImg(inner));
+
+			// one more pixel, as a new gradient pixel can join a neighbouring region
+			dirtyRects.push_back(expandRect(inner, 1));
+		}
+	}
+
+	// coarse localization on the updated gradient
+	Mat& gradImg = workBuffer(_ws.gradImg, inImg.size(), CV_8U);
+	_state.gradImg.copyTo(gradImg);
+	vector<vector<Point>> contours;
+	localizeObjects(gradImg, contours);
+	vector<RotatedRect>& orientedBoxes = _ws.orientedBoxes;
+	orientedBoundingBoxes(contours, orientedBoxes, _ws.contourPoints);
+
+	// reuse the previous result of every identical region clear of dirty rectangles
+	size_t n = contours.size();
+	vector<Rect> windows(n);
+	vector<BitMask> regionMasks(n);
+	vector<uchar> recompute(n, 1);
+	if(!refresh){
+		for(size_t i = 0; i < n; ++i){
+			RotatedRect regionBox;
+			Rect window = localRegionWindow(orientedBoxes[i], inImg.size(), regionBox);
+			bool dirty = false;
+			for(size_t k = 0; k < dirtyRects.size() && !dirty; ++k)
+				dirty = (window & dirtyRects[k]).area() > 0;
+			if(dirty)
+				continue;
+
+			for(size_t j = 0; j < _state.contours.size(); ++j){
+				if(_state.windows[j] == window && _state.contours[j] == contours[i]){
+					windows[i] = window;
+					regionMasks[i] = _state.regionMasks[j];
+					recompute[i] = 0;
+					break;
+				}
+			}
+		}
+	}
+	segmentLocalRegions(inImg, orientedBoxes, windows, regionMasks, &recompute);
+	mergeLocalRegions(windows, regionMasks, fgImg);
+
+	_state.contours.swap(contours);
+	_state.windows.swap(windows);
+	_state.regionMasks.swap(regionMasks);
+}
+
+// Finds the tiles that differ from the reference image by more than the change tolerance
+//     inImg        - input grayscale image
+//     changedRects - receives the changed tiles, horizontally adjacent ones merged
+//
+void FGExtraction::findChangedTiles(const Mat& inImg, vector<Rect>& changedRects)
+{
+	changedRects.clear();
+	for(int ty = 0; ty < inImg.rows; ty += _tileSize){
+		int tileRows = std::min(_tileSize, inImg.rows - ty);
+		Rect run;
+		for(int tx = 0; tx < inImg.cols; tx += _tileSize){
+			int tileCols = std::min(_tileSize, inImg.cols - tx);
+			bool changed = false;
+			for(int y = ty; y < ty + tileRows && !changed; ++y){
+				const uchar* inRow = inImg.ptr<uchar>(y);
+				const uchar* refRow = _state.refImg.ptr<uchar>(y);
+				for(int x = tx; x < tx + tileCols; ++x){
+					if(std::abs(inRow[x] - refRow[x]) > _changeTol){
+						changed = true;
+						break;
+					}
+				}
+			}
+
+			if(changed){
+				if(run.area() > 0)
+					run.width += tileCols;
+				else
+					run = Rect(tx, ty, tileCols, tileRows);
+			}
+			else if(run.area() > 0){
+				changedRects.push_back(run);
+				run = Rect();
+			}
+		}
+		if(run.area() > 0)
+			changedRects.push_back(run);
+	}
 }
 
 // Double local thresholding algorithm
-//     src     - input grayscale image
-//     dstHigh - binary object mask produced by high threshold
-//     dstLow  - binary object mask produced by low threshold
-//     roiMask - ROI binary mask
+//     src         - input grayscale image
+//     dstHigh     - binary object mask produced by high threshold
+//     dstLow      - binary object mask produced by low threshold
+//     roiMask     - ROI binary mask
+//     levelCounts - if not NULL, reused for the histogram of the Otsu threshold
 //
-void FGExtraction::doubleLocalThreshold(InputArray src, OutputArray dstHigh, OutputArray dstLow, Mat roiMask)
+void FGExtraction::doubleLocalThreshold(InputArray src, OutputArray dstHigh, OutputArray dstLow, Mat roiMask,
+										vector<int>* levelCounts)
 {
 	if(!src.obj) return;
 	Mat inImg = src.getMat();
@@ -126,166 +1309,273 @@ void FGExtraction::doubleLocalThreshold(InputArray src, OutputArray dstHigh, Out
 	Mat lowFgImg = dstLow.getMat();
 
 	int u = 0;
-	int thresh = getOtsuThreshold(inImg, 0, 255, &u, roiMask);
+	int thresh = getOtsuThreshold(inImg, 0, 255, &u, roiMask, levelCounts);
 	int highThresh = thresh - int(_pHigh*(thresh - u));
 	int lowThresh = thresh - int(_pLow*(thresh - u));
 
-	Mat maskedInImg;
-	bitwise_and(inImg, roiMask, maskedInImg);
-	
 	// generate high and low look-up tables
-	Mat highLUT(1, 256, CV_8U);
-	Mat lowLUT(1, 256, CV_8U);
-    uchar* highData = highLUT.data; 
-	uchar* lowData = lowLUT.data;
+	uchar highLUT[256];
+	uchar lowLUT[256];
     for(int i = 0; i < 256; ++i){
-        highData[i] = i <= highThresh ? 0 : 255;
-		lowData[i] = i <= lowThresh ? 0 : 255;
+        highLUT[i] = i <= highThresh ? 0 : 255;
+		lowLUT[i] = i <= lowThresh ? 0 : 255;
 	}
 
-	// threshold by using look-up tables
-	LUT(maskedInImg, highLUT, highFgImg);
-	LUT(maskedInImg, lowLUT, lowFgImg);
+	// mask the input and threshold it by both tables in one pass
+	for(int y = 0; y < inImg.rows; ++y){
+		const uchar* in = inImg.ptr<uchar>(y);
+		const uchar* roi = roiMask.ptr<uchar>(y);
+		uchar* high = highFgImg.ptr<uchar>(y);
+		uchar* low = lowFgImg.ptr<uchar>(y);
+		for(int x = 0; x < inImg.cols; ++x){
+			uchar v = in[x] & roi[x];
+			high[x] = highLUT[v];
+			low[x] = lowLUT[v];
+		}
+	}
 }
 
 // Computes the threshold using Otsu's method
-//     src       - input image
-//     lowerVal  - lower bound of pixel value
-//     upperVal  - upper bound of pixel value
-//     u1Ptr     - pointer to receive the mean of lower class
-//     roiMask   - ROI binary mask
+//     src         - input grayscale image
+//     lowerVal    - lower bound of pixel value
+//     upperVal    - upper bound of pixel value
+//     u1Ptr       - pointer to receive the mean of lower class
+//     roiMask     - ROI binary mask, empty for the whole image
+//     levelCounts - if not NULL, reused for the gray level histogram
 //
 //     returns : Otsu threshold value
 //
-int FGExtraction::getOtsuThreshold(InputArray src, int lowerVal, int upperVal, int* u1Ptr, Mat roiMask)
+int FGExtraction::getOtsuThreshold(InputArray src, int lowerVal, int upperVal, int* u1Ptr, Mat roiMask,
+								   vector<int>* levelCounts)
 {
 	if(!src.obj) return -1;
 	Mat inImg = src.getMat();
-	
-	int nbins = 256;
-	int channels[] = {0};
-	const int histSize[] = {nbins};
-    float range[] = {0, 255};
-    const float* ranges[] = {range};
-	Mat hist;
-    cv::calcHist(&inImg, 1, channels, roiMask, hist, 1, histSize, ranges);
-	
-	Mat_<float> hist_(hist);
-	float size = float(sum(hist)[0]);
+	CV_Assert(inImg.type() == CV_8U && (roiMask.empty() || roiMask.size() == inImg.size()));
 
-	float w1, w2, u1, u2;
-  	float max = -1;
-	int index = 1;
-	float u1max = -1;
-	float histMax = 0;
-	int mode = 0;
-	float count = 0;
-
-	for (int i = lowerVal+1; i < upperVal; ++i){	
-		if(hist_(i,0) > histMax) {
-			histMax = hist_(i,0);
-			mode = i;
-		}
-		w1 = 0;
-		
-		for (int j = lowerVal+1; j <= i; ++j){
-			w1 = w1 + hist_(j-1,0);
-		}
-		w1 = w1 / size;
-		w2 = 1 - w1;
-
-		u1 = 0;
-		count = 0;
-		for (int j = lowerVal; j <= i-1; ++j){
-			u1 = u1 + j*hist_(j,0);
-			count += hist_(j,0);
-		}
-		u1 /= count;
-
-		u2 = 0;
-		count = 0;
-		for (int j = i; j <= upperVal; ++j){
-			u2 = u2 + j*hist_(j, 0);
-			count += hist_(j, 0);
-		}
-		u2 /= count;
-
-		if (w1 * w2 * (u1-u2) * (u1-u2) > max){
-			max = w1 * w2 * (u1-u2) * (u1-u2);
-			index = i;
-			u1max = u1;
+	// one bin per gray level, counted directly instead of by calcHist
+	vector<int> localCounts;
+	vector<int>& counts = levelCounts ? *levelCounts : localCounts;
+	if(levelCounts && counts.capacity() < 256)
+		CV_XADD(&_allocCount, 1);
+	counts.assign(256, 0);
+	int* hist = &counts[0];
+	for(int y = 0; y < inImg.rows; ++y){
+		const uchar* in = inImg.ptr<uchar>(y);
+		if(roiMask.empty()){
+			for(int x = 0; x < inImg.cols; ++x)
+				++hist[in[x]];
 		}
 		else{
-			max = max;
-			index = index;
+			const uchar* roi = roiMask.ptr<uchar>(y);
+			for(int x = 0; x < inImg.cols; ++x)
+				hist[in[x]] += roi[x] != 0;
 		}
 	}
-	
-	*u1Ptr = (int)(u1max + 0.5);
-	return index;
+
+	// calcHist's range [0, 255) left gray level 255 out
+	hist[255] = 0;
+	return otsuThreshold(hist, 256, lowerVal, upperVal, u1Ptr);
+}
+
+// Computes the threshold using Otsu's method on a precomputed histogram
+//     hist      - histogram with any number of bins, as a row or a column
+//     lowerVal  - lower bound of bin index
+//     upperVal  - upper bound of bin index
+//     u1Ptr     - pointer to receive the mean of lower class
+//
+//     returns : Otsu threshold value (bin index)
+//
+int FGExtraction::getOtsuThreshold(const Mat& hist, int lowerVal, int upperVal, int* u1Ptr)
+{
+	// the converted copy is continuous, so rows and columns read the same
+	Mat_<double> hist_;
+	hist.convertTo(hist_, CV_64F);
+	return otsuThreshold(hist_.ptr<double>(0), (int)hist_.total(), lowerVal, upperVal, u1Ptr);
 }
 
 // merges low and high FG mask using histogram backprojection
 //    src       - input image
 //    srcHigh   - high object mask
 //    srcLow    - low object mask
+//    dst       - object mask to update
 //    roiMask   - ROI binary mask
+//    ws        - scratch buffers for the backprojection
 //
-void FGExtraction::updateByHistBackproject(InputArray src, InputArray srcHigh, InputArray srcLow, InputOutputArray dst, Mat roiMask)
+void FGExtraction::updateByHistBackproject(InputArray src, InputArray srcHigh, InputArray srcLow, InputOutputArray dst, Mat roiMask,
+										   RegionWorkspace& ws)
 {
 	if(!src.obj || !srcHigh.obj || !srcLow.obj || !dst.obj) return;
-	Mat inImg = src.getMat();
-	Mat highMask = srcHigh.getMat();
-	Mat lowMask = srcLow.getMat();
 	Mat fgImg = dst.getMat();
+	if(_fusedRegions){
+		uchar lut[256];
+		Mat inImg = src.getMat();
+		ratioHistLUT(inImg, srcHigh.getMat(), srcLow.getMat(), lut, ws);
+		orByLUT(inImg, lut, roiMask, fgImg);
+		return;
+	}
+	Mat ratioHistBP_8U = ratioHistBackproject(src.getMat(), srcHigh.getMat(), srcLow.getMat(), roiMask, ws);
+	bitwise_or(ratioHistBP_8U, fgImg, fgImg, roiMask);
+}
+
+// same as above for a bit mask object mask and ROI
+//    roiBits   - ROI bit mask, same size as src
+//
+void FGExtraction::updateByHistBackproject(InputArray src, InputArray srcHigh, InputArray srcLow, BitMask& dst, const BitMask& roiBits,
+										   RegionWorkspace& ws)
+{
+	if(!src.obj || !srcHigh.obj || !srcLow.obj) return;
+	Mat ratioHistBP_8U = ratioHistBackproject(src.getMat(), srcHigh.getMat(), srcLow.getMat(), Mat(), ws);
+	ws.bpBits.fromMat(ratioHistBP_8U, &_allocCount);
+	ws.bpBits &= roiBits;
+	dst |= ws.bpBits;
+}
+
+// Computes the thresholded ratio of the high and low histograms as a gray level
+// LUT, the 8-bit equivalent of ratioHistBackproject; both histograms are
+// counted in one pass over the region, with the bins calcHist would use
+//    inImg     - input image
+//    highMask  - high object mask
+//    lowMask   - low object mask
+//    lut       - receives 255 for the gray levels of object pixels, 0 otherwise
+//    ws        - scratch buffers for the histograms
+//
+void FGExtraction::ratioHistLUT(const Mat& inImg, const Mat& highMask, const Mat& lowMask, uchar* lut, RegionWorkspace& ws)
+{
+	// bin _binCount collects gray level 255, which calcHist leaves out
+	int nbins = _binCount;
+	ws.binCounts.assign(2 * (nbins + 1), 0);
+	int* highHist = &ws.binCounts[0];
+	int* lowHist = highHist + nbins + 1;
+	const int* binIndex = &_binIndex[0];
+	for(int y = 0; y < inImg.rows; ++y){
+		const uchar* in = inImg.ptr<uchar>(y);
+		const uchar* high = highMask.ptr<uchar>(y);
+		const uchar* low = lowMask.ptr<uchar>(y);
+		for(int x = 0; x < inImg.cols; ++x){
+			int bin = binIndex[in[x]];
+			highHist[bin] += high[x] != 0;
+			lowHist[bin] += low[x] != 0;
+		}
+	}
+
+	ratioLUT(highHist, lowHist, lut);
+}
+
+// Thresholds the ratio of the high and low histograms to a gray level LUT
+//    highHist  - high mask histogram, _binCount + 1 bins, the last one ignored
+//    lowHist   - low mask histogram of the same bins
+//    lut       - receives 255 for the gray levels of object pixels, 0 otherwise
+//
+void FGExtraction::ratioLUT(const int* highHist, const int* lowHist, uchar* lut) const
+{
+	// float ratio truncated at 1 and compared with theta, as the float
+	// division and threshold() of the multi-pass version do
+	int nbins = _binCount;
+	float theta = (float)_theta;
+	for(int i = 0; i < 256; ++i){
+		int bin = _binIndex[i];
+		float ratio = (bin < nbins && lowHist[bin]) ? std::min((float)((double)highHist[bin] / lowHist[bin]), 1.f) : 0.f;
+		lut[i] = ratio > theta ? 255 : 0;
+	}
+}
+
+// Sets the ROI pixels whose gray level the LUT selects, in a single sweep
+//    inImg     - input image
+//    lut       - 255 for selected gray levels, 0 otherwise
+//    roiMask   - ROI binary mask, same size as inImg
+//    dst       - object mask to update, same size as inImg
+//
+void FGExtraction::orByLUT(const Mat& inImg, const uchar* lut, const Mat& roiMask, Mat& dst)
+{
+	for(int y = 0; y < inImg.rows; ++y){
+		const uchar* in = inImg.ptr<uchar>(y);
+		const uchar* roi = roiMask.ptr<uchar>(y);
+		uchar* out = dst.ptr<uchar>(y);
+		for(int x = 0; x < inImg.cols; ++x)
+			out[x] |= roi[x] ? lut[in[x]] : 0;
+	}
+}
 
+// same as above for a bit mask object mask and ROI, filled 64 pixels at a
+// time; the ROI is applied a word at a time too
+//    roiBits   - ROI bit mask, same size as inImg
+//
+void FGExtraction::orByLUT(const Mat& inImg, const uchar* lut, const BitMask& roiBits, BitMask& dst)
+{
+	for(int y = 0; y < inImg.rows; ++y){
+		const uchar* in = inImg.ptr<uchar>(y);
+		const uint64* roi = roiBits.row(y);
+		uint64* bits = dst.row(y);
+		for(int w = 0; w < dst.wordsPerRow(); ++w){
+			int x0 = w*64;
+			int n = std::min(64, inImg.cols - x0);
+			uint64 word = 0;
+			for(int i = 0; i < n; ++i)
+				word |= (uint64)(lut[in[x0 + i]] != 0) << i;
+			bits[w] |= word & roi[w];
+		}
+	}
+}
+
+// Computes the thresholded backprojection of the ratio of the high and low histograms
+//    inImg     - input image
+//    highMask  - high object mask
+//    lowMask   - low object mask
+//    roiMask   - ROI binary mask
+//    ws        - scratch buffers for the histograms and the backprojection
+//
+//    returns : binary backprojection, CV_8U, in the scratch buffer of ws
+//
+Mat FGExtraction::ratioHistBackproject(const Mat& inImg, const Mat& highMask, const Mat& lowMask, Mat roiMask, RegionWorkspace& ws)
+{
 	// generate histograms of two foregrounds
     int channels[] = {0};
 	const int histSize[] = {_binCount};
     float range[] = {0, 255};
     const float* ranges[] = {range};
-	Mat highHist;
-    Mat lowHist;
+	Mat highHist = ws.highHist.get(Size(1, _binCount), CV_32F, &_allocCount);
+	Mat lowHist = ws.lowHist.get(Size(1, _binCount), CV_32F, &_allocCount);
     cv::calcHist(&inImg, 1, channels, highMask, highHist, 1, histSize, ranges);
 	cv::calcHist(&inImg, 1, channels, lowMask, lowHist, 1, histSize, ranges);
 	
 	// get the ratio histogram
-	Mat ratioHist = highHist / lowHist;
+	Mat ratioHist = ws.ratioHist.get(Size(1, _binCount), CV_32F, &_allocCount);
+	divide(highHist, lowHist, ratioHist);
 	threshold(ratioHist, ratioHist, 1.0, 1.0, THRESH_TRUNC);
 
 	// backproject the ratio histogram to image plane
-	Mat ratioHistBP = histBackProject(inImg, ratioHist, roiMask);
+	Mat ratioHistBP = ws.backProj.get(inImg.size(), CV_32F, &_allocCount);
+	histBackProject(inImg, ratioHist, roiMask, ratioHistBP);
 
 	// thresholding on the backprojection
 	threshold(ratioHistBP, ratioHistBP, _theta, 255, THRESH_BINARY);
-	Mat ratioHistBP_8U;
+	Mat ratioHistBP_8U = ws.backProj8U.get(inImg.size(), CV_8U, &_allocCount);
 	ratioHistBP.convertTo(ratioHistBP_8U, CV_8U);
-	bitwise_or(ratioHistBP_8U, fgImg, fgImg, roiMask);
+	return ratioHistBP_8U;
 }
 
 // Performs histogram backprojection
 //    src        - input image
 //    hist       - histogram to be backprojected
 //    roiMask    - ROI mask
+//    dst        - histogram backproject image, CV_32F
 //
-//    return : histogram backproject image
-//
-Mat FGExtraction::histBackProject(InputArray src, Mat hist, Mat roiMask)
+void FGExtraction::histBackProject(InputArray src, Mat hist, Mat roiMask, OutputArray dst)
 {
-	if(!src.obj) return Mat();
+	if(!src.obj) return;
 	Mat inImg = src.getMat();
-	int binWidth = hist.rows;
+	int nbins = (int)hist.total();
+	CV_Assert(nbins == _binCount);
 
-	// generate high and low look-up tables
+	// generate the look-up table, gray levels outside every bin backproject to 0
 	Mat lookUpTable(1, 256, CV_32F);
     for(int i = 0; i < 256; ++i)
-        lookUpTable.at<float>(0, i) = hist.at<float>(i/binWidth, 0);
+        lookUpTable.at<float>(0, i) = _binIndex[i] < nbins ? hist.at<float>(_binIndex[i]) : 0.f;
 
 	// perform histogram backprojection via the look-up table
-	Mat backProj = Mat(inImg.size(), CV_32F);
+	dst.create(inImg.size(), CV_32F);
+	Mat backProj = dst.getMat();
 	LUT(inImg, lookUpTable, backProj);
-	
-	return backProj;
 }
 
 // Selects the foreground objects based on area and variance
@@ -300,52 +1590,39 @@ void FGExtraction::thresholdByAreaVar(InputArray src, InputArray srcFg, OutputAr
     Mat fgImg = srcFg.getMat();
     dst.create(fgImg.size(), CV_8U);
     Mat outImg = dst.getMat();
+	StageScope scope(_stats, _trace, FGExtractionStats::STAGE_AREA_VAR, fgImg.total());
     
 	// connect separate parts before finding connected components
-	Mat closeSE = getStructuringElement(MORPH_ELLIPSE, Size(_areaSESize, _areaSESize));
-	morphologyEx(fgImg, outImg, MORPH_CLOSE, closeSE);
+	if(_fastMorphology){
+		morphologyBySpans(fgImg, outImg, MORPH_CLOSE, _areaSpans, &_ws.morph, &_allocCount);
+	}
+	else{
+		Mat closeSE = getStructuringElement(MORPH_ELLIPSE, Size(_areaSESize, _areaSESize));
+		morphologyEx(fgImg, outImg, MORPH_CLOSE, closeSE);
+	}
     
 	// extract contours of targets
-    vector<vector<Point>> contours = extractContours(outImg);
+    vector<vector<Point>> contours = extractContours(outImg, _ws.contourImg);
+	if(contours.empty()) return;
 
+	// each target is the filled region of its contour, as runs in its bounding
+	// box, so the statistics and the clearing only visit the target's pixels;
+	// filled external contours never overlap, so the order does not matter
+	RLERegion& target = _ws.targetRegion;
 	for(size_t i = 0; i < contours.size(); ++i){
-		bool passArea = false;
-        bool passVar = false;
-	
 		// check if the area is within the desired range
 		double area = contourArea(contours[i]);
-        if (area >= _minArea && area <= _maxArea) 
-			passArea = true;
-		
-		// check if the variance of pixel exceeds the threshold
-		Mat objFgImg = Mat::zeros(outImg.size(), CV_8U);
-        drawContours(objFgImg, contours, i, Scalar(255), -1);
-        
-        int n = 0;
-        double mean = 0;
-        double SSD = 0;
-        double tempVar = 0;
-        
-        for(int y = 0; y < objFgImg.rows; ++y){
-            for(int x = 0; x < objFgImg.cols; ++x){
-                if(objFgImg.at<uchar>(y, x) > 0){
-                    ++n;
-                    uchar px = inImg.at<uchar>(y, x);
-                    double delta = px - mean;
-                    mean += delta / n;
-                    SSD += delta*(px - mean);
-                    tempVar = SSD / (n == 1 ? n : (n-1));
-                }
-            }
-        }
-
-        double var = tempVar;
-        passVar = var >= _minVar;
+        bool passArea = area >= _minArea && area <= _maxArea;
+
+		// check if the sample variance of pixels exceeds the threshold
+		target.fromContour(contours[i], _ws.targetWindow, &_allocCount);
+		double mean, var;
+		regionMeanVar(inImg, target, mean, var);
+        bool passVar = var >= _minVar;
         
 		// remove the target if any of the tests fails
-		if(!passArea || !passVar){
-			drawContours(outImg, contours, i, Scalar(0), -1);
-		}
+		if(!passArea || !passVar)
+			target.fill(outImg, 0);
 	}
 }
 
@@ -359,10 +1636,17 @@ void FGExtraction::postProcessing(InputArray src, OutputArray dst)
 	Mat inImg = src.getMat();
     dst.create(inImg.size(), inImg.type());
     Mat outImg = dst.getMat();
+	StageScope scope(_stats, _trace, FGExtractionStats::STAGE_POST, inImg.total());
 	
+	// the fused version streams rows through all six passes at once
+	if(_fastMorphology){
+		closeOpenCloseBySpans(inImg, outImg, _postSpans, &_ws.morph, &_allocCount);
+		return;
+	}
+
 	Mat se = getStructuringElement(MORPH_ELLIPSE, Size(_postSESize, _postSESize));
     
-    Mat tempImg;
+    Mat& tempImg = workBuffer(_ws.tempImg, inImg.size(), inImg.type());
 	morphologyEx(inImg, tempImg, MORPH_CLOSE, se);
 	morphologyEx(tempImg, tempImg, MORPH_OPEN, se);
 	morphologyEx(tempImg, outImg, MORPH_CLOSE, se);
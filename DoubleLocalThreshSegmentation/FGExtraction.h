@@ -15,12 +15,19 @@
 
 #include <iostream>
 #include <cmath>
+#include <functional>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
 #include "util.h"
+#include "Morphology.h"
+#include "MajorityFilter.h"
+#include "BitMask.h"
+#include "RLERegion.h"
+#include "ObjectList.h"
+#include "Instrumentation.h"
 
 using namespace std;
 using namespace cv;
@@ -30,14 +37,155 @@ using namespace cv;
 class FGExtraction
 {
 public:
+	// called as each frame of a batch is done, possibly from several threads at once
+	//     index - position of the frame in the batch
+	//     fgImg - binary object mask of the frame
+	typedef std::function<void(size_t index, const Mat& fgImg)> FrameCallback;
+
+	// stores the next frame of a batch in its argument, or returns false at the end
+	typedef std::function<bool(Mat& inImg)> FrameReader;
+
 	FGExtraction(double minArea, double maxArea, double minVar, 
 				 double pHigh, double pLow, 
                  double theta, int nbins,
 				 int gradSESize, int areaSESize, int postSESize);
-	~FGExtraction();
+	virtual ~FGExtraction();
 
 	// object segmentation method
-	void extractForeground(InputArray inImg, OutputArray fgImg);
+	//     stats - if not NULL, receives the stage timings and work counters of this call
+	void extractForeground(InputArray inImg, OutputArray fgImg, FGExtractionStats* stats = NULL);
+
+	// same, and also returns each object of the mask as runs, so that per-object
+	// work downstream scales with the object rather than the frame
+	//     objects - pixels of the mask enclosed by each object's outer contour
+	void extractForeground(InputArray inImg, OutputArray fgImg, vector<RLERegion>& objects,
+						   FGExtractionStats* stats = NULL);
+
+	// the objects of the mask as a list, for consumers that need per-object data
+	// rather than an image; see ObjectList.h for storing them
+	//     objects - receives each object's runs, bounding box, area, gray level
+	//               mean and variance, and oriented box
+	//     fgImg   - if given, receives the mask as well
+	void extractObjects(InputArray inImg, vector<SegmentedObject>& objects, OutputArray fgImg = noArray(),
+						FGExtractionStats* stats = NULL);
+
+	// segments independent frames on one work-stealing pool; each frame and each
+	// local region inside it is a task of its own, so the regions of a crowded
+	// frame spread over the threads while other frames are still localized.
+	// Frames are done from scratch with the current settings, temporal mode
+	// and stats do not apply. An unreadable frame, or one a stage throws on,
+	// gets an empty mask and the batch goes on; so does a frame whose callback
+	// throws, and a frame the reader throws on is the last one
+	//     fgImgs      - receives the object mask of each frame
+	//     onFrameDone - if set, sees each mask as soon as its frame is done
+	//     threads     - pool size, 0 for one per hardware thread
+	void extractForegroundBatch(const vector<Mat>& inImgs, vector<Mat>& fgImgs,
+								const FrameCallback& onFrameDone = FrameCallback(), int threads = 0);
+
+	// same for frames from an input iterator, which is advanced only as the pool
+	// has room for another frame, so [first, last) may decode lazily; the masks
+	// are only passed to onFrameDone
+	template<class InputIt>
+	void extractForegroundBatch(InputIt first, InputIt last, const FrameCallback& onFrameDone, int threads = 0)
+	{
+		FrameReader next = [&first, &last](Mat& inImg) -> bool {
+			if(first == last)
+				return false;
+			inImg = *first;
+			++first;
+			return true;
+		};
+		runBatch(next, onFrameDone, NULL, threads);
+	}
+
+	// records stages and regions of all threads as trace events, NULL to stop
+	void setTraceSink(TraceSink* sink) { _trace = sink; }
+
+	// process each local region inside its own bounding window only
+	void setRegionLocal(bool enable) { _regionLocal = enable; }
+
+	// segment local regions concurrently with cv::parallel_for_ (region-local mode only)
+	void setParallelRegions(bool enable) { _parallelRegions = enable; }
+
+	// use the span-based morphology of Morphology.h instead of cv::morphologyEx,
+	// and the majority vote of MajorityFilter.h instead of medianBlur on the
+	// thresholded region masks; the masks are identical, only the speed differs
+	void setFastMorphology(bool enable) { _fastMorphology = enable; }
+
+	// merge the high and low masks of a region with one histogram pass and one
+	// 8-bit LUT sweep instead of calcHist and a float backprojection; the masks
+	// are identical, only the speed differs
+	void setFusedRegions(bool enable) { _fusedRegions = enable; }
+
+	// coarse localization on a downscaled pyramid level, 0 for full resolution;
+	// each level halves the frame, the area limits and the gradient SE are
+	// scaled to match, and the contours are mapped back to full resolution,
+	// where the local regions are segmented as usual (not in temporal mode)
+	void setPyramidLevel(int level);
+	int pyramidLevel() const { return _pyramidLevel; }
+
+	// margin a tile of a larger image needs for its core to be segmented as in
+	// the whole image, for objects up to maxObjectSize pixels across
+	int tileHalo(int maxObjectSize) const;
+
+	// return an empty mask right after a cheap check of the gradient activity
+	// when no gradient region of the frame can reach the minimum area; the
+	// check never rejects a frame with objects, so the masks are identical
+	void setEmptyFrameCheck(bool enable) { _emptyFrameCheck = enable; }
+
+	// keep the masks of the last capacity frames and answer a frame that
+	// differs from one of them by at most tolerance gray levels in every pixel
+	// from the cache; tolerance 0 reuses exact duplicates only, and capacity 0
+	// turns the cache off. Not used in temporal mode or by batches
+	void setFrameCache(int capacity, int tolerance = 0);
+	void clearFrameCache() { _frameCache.clear(); }
+
+	// temporal incremental mode for consecutive frames of one stream: only the
+	// regions near tiles that changed by more than changeTol gray levels are
+	// segmented again, and every refreshInterval-th frame is done from scratch;
+	// it always uses the region-local engine
+	void setTemporalMode(bool enable, int tileSize = 64, int changeTol = 8, int refreshInterval = 30);
+	void resetTemporalState();
+
+	// number of times a buffer of the instance's workspace was (re)allocated:
+	// the frame-sized work images, the filters and row buffers of the span
+	// morphology, and the per-region scratch images, bit masks, histograms
+	// and run-length windows. It stops growing once the workspace fits the
+	// frame geometry and the region sizes in use. It does not see
+	// allocations outside the workspace: those inside OpenCV calls such as
+	// findContours and medianBlur, the contour vectors, the block maps and
+	// thumbnails of the empty frame check and the frame cache, temporal
+	// mode's gradient windows, and the caller's output images
+	int allocationCount() const { return _allocCount; }
+	void resetAllocationCount() { _allocCount = 0; }
+
+	// Otsu threshold of a precomputed histogram with any number of bins
+	static int getOtsuThreshold(const Mat& hist, int lowerVal, int upperVal, int* u1Ptr);
+
+protected:
+	// scratch buffers of one local region
+	struct RegionWorkspace
+	{
+		ScratchMat	mask;
+		ScratchMat	highRaw;
+		ScratchMat	lowRaw;
+		ScratchMat	highImg;
+		ScratchMat	lowImg;
+		ScratchMat	backProj;
+		ScratchMat	backProj8U;
+		BitMask		roiBits;
+		BitMask		bpBits;
+		vector<int>	binCounts;	// high and low histograms of the fused kernel
+		vector<int>	levelCounts;	// gray level histogram of the Otsu threshold
+		ScratchMat	highHist;	// calcHist histograms of the multi-pass merge
+		ScratchMat	lowHist;
+		ScratchMat	ratioHist;
+	};
+
+	// hooks of the compile-time specialized variant, see FixedFGExtraction.h
+	virtual FGExtraction* clone() const;
+	virtual void ratioHistLUT(const Mat& inImg, const Mat& highMask, const Mat& lowMask, uchar* lut, RegionWorkspace& ws);
+	double theta() const { return _theta; }
 
 private:
 	double	_minArea;
@@ -46,18 +194,146 @@ private:
 	double  _pHigh;
 	double  _pLow;
     double  _theta;
-    double  _binCount;
+    int     _binCount;
 	int     _gradSESize;
     int     _areaSESize;
 	int     _postSESize;
+	bool    _regionLocal;
+	bool    _parallelRegions;
+	bool    _fastMorphology;
+	bool    _fusedRegions;
+	int     _pyramidLevel;
+	int     _pyrGradSESize;
+	bool    _temporalMode;
+	int     _tileSize;
+	int     _changeTol;
+	int     _refreshInterval;
+	bool    _emptyFrameCheck;
+	int     _frameCacheCapacity;
+	int     _frameCacheTol;
+
+	// elliptical structuring elements as row spans
+	vector<MorphSpan>	_gradSpans;
+	vector<MorphSpan>	_areaSpans;
+	vector<MorphSpan>	_postSpans;
+	vector<MorphSpan>	_pyrGradSpans;
+
+	// histogram bin of each gray level as calcHist assigns it, _binCount if none
+	vector<int>			_binIndex;
+
+	// state carried from frame to frame in temporal mode
+	struct TemporalState
+	{
+		int						frameCount;
+		Mat						refImg;		// input as of the last time each tile changed
+		Mat						gradImg;	// thresholded gradient before area filtering
+		vector<vector<Point>>	contours;
+		vector<Rect>			windows;
+		vector<BitMask>			regionMasks;
+	} _state;
+
+	// a recently segmented frame, see setFrameCache
+	struct CachedFrame
+	{
+		uint64					signature;
+		Mat						inImg;
+		Mat						fgImg;
+		bool					hasObjects;
+		vector<SegmentedObject>	objects;
+	};
+	vector<CachedFrame>	_frameCache;	// most recently used first
+
+	// buffers reused from call to call, one call at a time per instance
+	struct Workspace
+	{
+		Mat						grayImg;
+		Mat						gradImg;
+		Mat						pyrGradImg;
+		vector<Mat>				pyramid;
+		Mat						fgImg;
+		Mat						maskImg;
+		ScratchMat				targetWindow;
+		RLERegion				targetRegion;
+		RLERegion				maskRegion;
+		Mat						tempImg;
+		Mat						contourImg;
+		MorphWorkspace			morph;
+		BitMask					fgBits;
+		vector<Rect>			windows;
+		vector<BitMask>			regionMasks;
+		vector<RegionWorkspace>	regions;
+		ContourPoints			contourPoints;
+		vector<RotatedRect>		orientedBoxes;
+	} _ws;
+	int _allocCount;
+
+	// instrumentation of the current call, both NULL when disabled
+	FGExtractionStats*	_stats;
+	TraceSink*			_trace;
+
+	Mat& workBuffer(Mat& buf, Size size, int type);
 	
+	friend class LocalRegionBody;
+	friend class BatchScheduler;
+	friend class StageBenchmark;	// times the private stages, see bench_main.cpp
+	friend class ParameterSweep;
+	friend class SegmentationServer;
+	friend class TiledSegmentation;
+
+	void setParameters(double minArea, double maxArea, double minVar, double pHigh, double pLow,
+					   double theta, int nbins, int gradSESize, int areaSESize, int postSESize);
+	void updateTables();
+
+	// stages shared by single frames and batches
+	Mat grayInput(const Mat& inImg);
+	void segmentFrame(InputArray src, OutputArray dst, vector<SegmentedObject>* objects, FGExtractionStats* stats);
+	void segmentObjects(const Mat& inImg, OutputArray dst, vector<SegmentedObject>* objects);
+	void finishForeground(const Mat& inImg, Mat& fgImg, OutputArray dst, vector<SegmentedObject>* objects = NULL);
+	void runBatch(const FrameReader& next, const FrameCallback& onFrameDone, vector<Mat>* fgImgs, int threads);
+
+	// shortcuts for frames without objects and repeated frames
+	bool mayContainObjects(const Mat& inImg);
+	bool lookupFrameCache(const Mat& inImg, uint64 signature, OutputArray dst, vector<SegmentedObject>* objects);
+	void storeFrameCache(const Mat& inImg, uint64 signature, const Mat& fgImg, const vector<SegmentedObject>* objects);
+	static uint64 frameSignature(const Mat& inImg);
+
+	// coarse object localization
+	void coarseLocalize(const Mat& inImg, vector<vector<Point>>& contours);
+	void coarseGradient(const Mat& inImg, Mat& gradImg);
+	void coarseGradient(const Mat& inImg, Mat& gradImg, int seSize, const vector<MorphSpan>& spans);
+	void localizeObjects(Mat& gradImg, vector<vector<Point>>& contours, double areaScale = 1);
+
+	// local region segmentation
+	void segmentLocalRegions(const Mat& inImg, const vector<RotatedRect>& orientedBoxes,
+							 vector<Rect>& windows, vector<BitMask>& regionMasks, const vector<uchar>* recompute);
+	void mergeLocalRegions(const vector<Rect>& windows, const vector<BitMask>& regionMasks, Mat& fgImg);
+	Rect localRegionWindow(const RotatedRect& orientedBox, Size imgSize, RotatedRect& regionBox);
+	void segmentLocalRegion(const Mat& inImg, const RotatedRect& objectBox, Rect& window, BitMask& regionMask,
+							RegionWorkspace& ws);
+	void medianFilter(const Mat& src, Mat& dst);
+
+	// temporal incremental segmentation
+	void segmentIncremental(const Mat& inImg, Mat& fgImg);
+	void findChangedTiles(const Mat& inImg, vector<Rect>& changedRects);
+
 	// double local thresholding methods
-	void doubleLocalThreshold(InputArray src, OutputArray dstHigh, OutputArray dstLow, Mat roiMask);
-	int getOtsuThreshold(InputArray src, int lowerVal, int upperVal, int* u1Ptr, Mat roiMask);
+	void doubleLocalThreshold(InputArray src, OutputArray dstHigh, OutputArray dstLow, Mat roiMask,
+							  vector<int>* levelCounts = NULL);
+	int getOtsuThreshold(InputArray src, int lowerVal, int upperVal, int* u1Ptr, Mat roiMask,
+						 vector<int>* levelCounts = NULL);
 
 	// histogram backprojection methods
-	void updateByHistBackproject(InputArray src, InputArray srcHigh, InputArray srcLow, InputOutputArray dst, Mat roiMask);
-	Mat histBackProject(InputArray src, Mat hist, Mat roiMask);
+	void updateByHistBackproject(InputArray src, InputArray srcHigh, InputArray srcLow, InputOutputArray dst, Mat roiMask,
+								 RegionWorkspace& ws);
+	void updateByHistBackproject(InputArray src, InputArray srcHigh, InputArray srcLow, BitMask& dst, const BitMask& roiBits,
+								 RegionWorkspace& ws);
+	void ratioLUT(const int* highHist, const int* lowHist, uchar* lut) const;
+	Mat ratioHistBackproject(const Mat& inImg, const Mat& highMask, const Mat& lowMask, Mat roiMask, RegionWorkspace& ws);
+	void histBackProject(InputArray src, Mat hist, Mat roiMask, OutputArray dst);
+
+	// fused histogram backprojection
+	static void orByLUT(const Mat& inImg, const uchar* lut, const Mat& roiMask, Mat& dst);
+	static void orByLUT(const Mat& inImg, const uchar* lut, const BitMask& roiBits, BitMask& dst);
 
 	// threshold by area and variance
 	void thresholdByAreaVar(InputArray src, InputArray srcFg, OutputArray dst);
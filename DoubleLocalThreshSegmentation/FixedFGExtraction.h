@@ -0,0 +1,109 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  FixedFGExtraction.h
+//  Date:   Oct/16/2026
+//
+//  FGExtraction with the histogram bin count fixed at compile time, for
+//  production runs of one configuration. The gray level to bin table is
+//  generated by the compiler, and the histograms of the fused region kernel
+//  are NBins-sized arrays with loops of constant trip count. The structuring
+//  element sizes stay constructor arguments: the span morphology costs the
+//  same per pixel whatever the span lengths, so fixing them would only
+//  unroll the loop over the few SE rows.
+//  Masks are identical to those of FGExtraction with the same parameters,
+//  which stays the class to use for experimenting with them.
+//
+//  Needs constexpr and variadic templates (Visual Studio 2015 or later).
+//
+
+#ifndef _FIXEDFGEXTRACTION_H_
+#define _FIXEDFGEXTRACTION_H_
+
+#include <algorithm>
+
+#include "FGExtraction.h"
+
+//********** compile-time tables *************************************************
+
+// 0, 1, ..., N-1 as a parameter pack
+template<int... I> struct IndexList {};
+template<int N, int... I> struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...> {};
+template<int... I> struct MakeIndexList<0, I...> { typedef IndexList<I...> type; };
+
+constexpr int constMin(int a, int b) { return a < b ? a : b; }
+
+// bin of a gray level as calcHist assigns it for nbins bins over [0, 255),
+// nbins for 255, which lies outside every bin
+constexpr int histBin(int nbins, int value)
+{
+	return constMin(int(value * (double(nbins) / 255.0)), nbins);
+}
+
+template<int NBins, class Levels = typename MakeIndexList<256>::type>
+struct HistBinTable;
+
+// bin of each gray level for NBins bins
+template<int NBins, int... I>
+struct HistBinTable<NBins, IndexList<I...>>
+{
+	static constexpr uchar index[256] = { uchar(histBin(NBins, I))... };
+};
+
+template<int NBins, int... I>
+constexpr uchar HistBinTable<NBins, IndexList<I...>>::index[256];
+
+//********** class FixedFGExtraction *********************************************
+
+template<int NBins>
+class FixedFGExtraction : public FGExtraction
+{
+	static_assert(NBins >= 1 && NBins <= 255, "the bin table stores bins as uchar");
+
+public:
+	FixedFGExtraction(double minArea, double maxArea, double minVar, double pHigh, double pLow, double theta,
+					  int gradSESize, int areaSESize, int postSESize)
+		: FGExtraction(minArea, maxArea, minVar, pHigh, pLow, theta, NBins, gradSESize, areaSESize, postSESize)
+	{
+
+	}
+
+protected:
+	FGExtraction* clone() const
+	{
+		return new FixedFGExtraction(*this);
+	}
+
+	// Same as FGExtraction::ratioHistLUT with the bin count, the bin table and
+	// the histograms fixed at compile time
+	void ratioHistLUT(const Mat& inImg, const Mat& highMask, const Mat& lowMask, uchar* lut, RegionWorkspace& ws)
+	{
+		const uchar* binIndex = HistBinTable<NBins>::index;
+
+		// the extra bin collects gray level 255, which calcHist leaves out
+		int highHist[NBins + 1] = {0};
+		int lowHist[NBins + 1] = {0};
+		for(int y = 0; y < inImg.rows; ++y){
+			const uchar* in = inImg.ptr<uchar>(y);
+			const uchar* high = highMask.ptr<uchar>(y);
+			const uchar* low = lowMask.ptr<uchar>(y);
+			for(int x = 0; x < inImg.cols; ++x){
+				int bin = binIndex[in[x]];
+				highHist[bin] += high[x] != 0;
+				lowHist[bin] += low[x] != 0;
+			}
+		}
+
+		float theta = (float)this->theta();
+		uchar binValue[NBins + 1];
+		for(int i = 0; i < NBins; ++i){
+			float ratio = lowHist[i] ? std::min((float)((double)highHist[i] / lowHist[i]), 1.f) : 0.f;
+			binValue[i] = ratio > theta ? 255 : 0;
+		}
+		binValue[NBins] = 0;
+
+		for(int i = 0; i < 256; ++i)
+			lut[i] = binValue[binIndex[i]];
+	}
+};
+
+#endif
@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Instrumentation.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <map>
+#include <thread>
+
+#include "Instrumentation.h"
+
+//********** struct FGExtractionStats ********************************************
+
+void FGExtractionStats::reset()
+{
+	totalMs = 0;
+	for(int i = 0; i < STAGE_COUNT; ++i){
+		stageMs[i] = 0;
+		stagePixels[i] = 0;
+	}
+	coarseContours = 0;
+	regions = 0;
+	emptyFrame = false;
+	cacheHit = false;
+	regionStats.clear();
+}
+
+const char* FGExtractionStats::stageName(int stage)
+{
+	static const char* names[STAGE_COUNT] = {
+		"grayscale", "coarse_gradient", "localization", "local_regions",
+		"merge_regions", "threshold_by_area_var", "post_processing", "final_area_filter"
+	};
+	return (stage >= 0 && stage < STAGE_COUNT) ? names[stage] : "unknown";
+}
+
+//********** class TraceSink *****************************************************
+
+TraceSink::TraceSink()
+	: _file(NULL), _origin(0), _first(true)
+{
+
+}
+
+TraceSink::~TraceSink()
+{
+	close();
+}
+
+// Starts a new trace file
+//     filename - output JSON file
+//
+//     returns : false if the file cannot be created
+//
+bool TraceSink::open(const string& filename)
+{
+	close();
+	std::lock_guard<std::mutex> lock(_mutex);
+	_file = fopen(filename.c_str(), "w");
+	if(!_file)
+		return false;
+	fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", _file);
+	_origin = getTickCount();
+	_first = true;
+	return true;
+}
+
+void TraceSink::close()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if(!_file)
+		return;
+	fputs("\n]}\n", _file);
+	fclose(_file);
+	_file = NULL;
+}
+
+void TraceSink::complete(const char* name, const char* category, int64 start, int64 end, const string& args)
+{
+	double usPerTick = 1e6 / getTickFrequency();
+	int tid = currentThreadId();
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	if(!_file)
+		return;
+	fprintf(_file, "%s{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d, \"args\": {%s}}",
+			_first ? "" : ",\n", name, category, (start - _origin) * usPerTick, (end - start) * usPerTick, tid, args.c_str());
+	_first = false;
+}
+
+//********** functions *******************************************************************************
+
+// ids of the threads seen so far
+static std::mutex idMutex;
+static std::map<std::thread::id, int> ids;
+
+int currentThreadId()
+{
+	std::lock_guard<std::mutex> lock(idMutex);
+	std::map<std::thread::id, int>::iterator it = ids.find(std::this_thread::get_id());
+	if(it != ids.end())
+		return it->second;
+	int id = (int)ids.size();
+	ids[std::this_thread::get_id()] = id;
+	return id;
+}
+
+double ticksToMs(int64 ticks)
+{
+	return ticks * 1000.0 / getTickFrequency();
+}
@@ -0,0 +1,103 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Instrumentation.h
+//  Date:   Oct/16/2026
+//
+//  Per-call statistics of FGExtraction::extractForeground and a trace sink
+//  writing Chrome trace event JSON (chrome://tracing, ui.perfetto.dev).
+//  Both are opt-in; when neither is set, every hook is a null pointer test.
+//
+
+#ifndef _INSTRUMENTATION_H_
+#define _INSTRUMENTATION_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include <opencv2/core/core.hpp>
+
+using namespace std;
+using namespace cv;
+
+//********** struct FGExtractionStats ********************************************
+
+// timing of one local region
+struct RegionStats
+{
+	RegionStats() : ms(0), thread(-1), computed(false) {}
+
+	Rect	window;		// region window in the frame
+	double	ms;			// wall time of the region
+	int		thread;		// worker thread, see currentThreadId()
+	bool	computed;	// false if reused from the previous frame (temporal mode)
+};
+
+// wall time and work counters of one extractForeground call
+struct FGExtractionStats
+{
+	enum Stage
+	{
+		STAGE_GRAYSCALE = 0,	// color conversion
+		STAGE_GRADIENT,			// thresholded morphological gradient
+		STAGE_LOCALIZATION,		// contour area filtering
+		STAGE_REGIONS,			// local region segmentation
+		STAGE_MERGE,			// merging of the region masks
+		STAGE_AREA_VAR,			// thresholding by area and variance
+		STAGE_POST,				// morphological post-processing
+		STAGE_FINAL_AREA,		// final area filtering
+		STAGE_COUNT
+	};
+
+	FGExtractionStats() { reset(); }
+	void reset();
+
+	static const char* stageName(int stage);
+
+	double	totalMs;
+	double	stageMs[STAGE_COUNT];		// wall time per stage
+	int64	stagePixels[STAGE_COUNT];	// pixels processed per stage
+	int		coarseContours;				// contours of the thresholded gradient
+	int		regions;					// contours left after area filtering
+	bool	emptyFrame;					// answered by the empty frame check
+	bool	cacheHit;					// answered by the frame cache
+	vector<RegionStats> regionStats;
+};
+
+//********** class TraceSink *****************************************************
+
+// Thread-safe writer of Chrome trace "complete" events; events of all threads
+// share one file and are timestamped relative to when it was opened
+class TraceSink
+{
+public:
+	TraceSink();
+	~TraceSink();
+
+	bool open(const string& filename);
+	void close();
+	bool isOpen() const { return _file != NULL; }
+
+	// records an event from start to end, both in getTickCount() ticks
+	//     args - contents of the JSON "args" object, e.g. "\"regions\": 3"
+	void complete(const char* name, const char* category, int64 start, int64 end, const string& args = string());
+
+private:
+	std::mutex	_mutex;
+	FILE*		_file;
+	int64		_origin;
+	bool		_first;
+
+	TraceSink(const TraceSink&);
+	TraceSink& operator=(const TraceSink&);
+};
+
+//********** functions *******************************************************************************
+
+// small sequential id of the calling thread, 0 for the first one asking
+int currentThreadId();
+
+double ticksToMs(int64 ticks);
+
+#endif
@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  MajorityFilter.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <algorithm>
+
+#include "MajorityFilter.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MAJORITY_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MAJORITY_SSE2
+#endif
+
+//********** majority filter *************************************************************************
+
+// vote at x; xl and xr are the neighbouring columns, already replicated at the border
+static inline uchar majorityAt(const uchar* r0, const uchar* r1, const uchar* r2, int xl, int x, int xr)
+{
+	int count = (r0[xl] != 0) + (r0[x] != 0) + (r0[xr] != 0)
+			  + (r1[xl] != 0) + (r1[x] != 0) + (r1[xr] != 0)
+			  + (r2[xl] != 0) + (r2[x] != 0) + (r2[xr] != 0);
+	return count >= 5 ? 255 : 0;
+}
+
+// Interior columns of one row, [x, end) with end < cols so that x+1 is in
+// the row for every x; returns the first column not processed
+static int majorityRowSIMD(const uchar* r0, const uchar* r1, const uchar* r2, uchar* out, int x, int end)
+{
+#ifdef MAJORITY_AVX2
+	const __m256i threshold32 = _mm256_set1_epi8(-4);
+	for(; x + 32 <= end; x += 32){
+		__m256i sum = _mm256_loadu_si256((const __m256i*)(r0 + x - 1));
+		sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i*)(r0 + x)));
+		sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i*)(r0 + x + 1)));
+		sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i*)(r1 + x - 1)));
+		sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i*)(r1 + x)));
+		sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i*)(r1 + x + 1)));
+		sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i*)(r2 + x - 1)));
+		sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i*)(r2 + x)));
+		sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i*)(r2 + x + 1)));
+		_mm256_storeu_si256((__m256i*)(out + x), _mm256_cmpgt_epi8(threshold32, sum));
+	}
+#endif
+#ifdef MAJORITY_SSE2
+	const __m128i threshold16 = _mm_set1_epi8(-4);
+	for(; x + 16 <= end; x += 16){
+		__m128i sum = _mm_loadu_si128((const __m128i*)(r0 + x - 1));
+		sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i*)(r0 + x)));
+		sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i*)(r0 + x + 1)));
+		sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i*)(r1 + x - 1)));
+		sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i*)(r1 + x)));
+		sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i*)(r1 + x + 1)));
+		sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i*)(r2 + x - 1)));
+		sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i*)(r2 + x)));
+		sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i*)(r2 + x + 1)));
+		_mm_storeu_si128((__m128i*)(out + x), _mm_cmplt_epi8(sum, threshold16));
+	}
+#endif
+	(void)r0; (void)r1; (void)r2; (void)out; (void)end;
+	return x;
+}
+
+// 3x3 median of a binary mask
+//     src - input CV_8U mask, every pixel 0 or 255
+//     dst - output mask, must not share data with src
+//
+void binaryMedian3x3(InputArray _src, OutputArray _dst)
+{
+	Mat src = _src.getMat();
+	CV_Assert(src.type() == CV_8U);
+	_dst.create(src.size(), CV_8U);
+	Mat dst = _dst.getMat();
+	CV_Assert(src.data != dst.data || src.empty());
+
+	int rows = src.rows, cols = src.cols;
+	for(int y = 0; y < rows; ++y){
+		const uchar* r0 = src.ptr<uchar>(std::max(y - 1, 0));
+		const uchar* r1 = src.ptr<uchar>(y);
+		const uchar* r2 = src.ptr<uchar>(std::min(y + 1, rows - 1));
+		uchar* out = dst.ptr<uchar>(y);
+		if(cols == 0)
+			continue;
+
+		// the border columns replicate, the others read x-1 and x+1 as they are
+		out[0] = majorityAt(r0, r1, r2, 0, 0, std::min(1, cols - 1));
+		int x = majorityRowSIMD(r0, r1, r2, out, 1, cols - 1);
+		for(; x < cols - 1; ++x)
+			out[x] = majorityAt(r0, r1, r2, x - 1, x, x + 1);
+		if(cols > 1)
+			out[cols - 1] = majorityAt(r0, r1, r2, cols - 2, cols - 1, cols - 1);
+	}
+}
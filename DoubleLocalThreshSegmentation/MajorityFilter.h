@@ -0,0 +1,26 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  MajorityFilter.h
+//  Date:   Oct/16/2026
+//
+//  3x3 median of binary masks. On a mask holding only 0 and 255 the median
+//  of nine pixels is 255 exactly when at least five of them are set, so the
+//  filter is a 5-of-9 vote: as signed bytes a set pixel is -1, and the sum
+//  of the nine neighbours is below -4 for a majority. The vote runs on 32
+//  pixels per instruction with AVX2, 16 with SSE2, one otherwise.
+//
+
+#ifndef _MAJORITYFILTER_H_
+#define _MAJORITYFILTER_H_
+
+#include <opencv2/core/core.hpp>
+
+using namespace cv;
+
+//********** majority filter *************************************************************************
+
+// same as medianBlur(src, dst, 3), including its replicated border, for a
+// CV_8U mask of 0 and 255 only; dst must not be src
+void binaryMedian3x3(InputArray src, OutputArray dst);
+
+#endif
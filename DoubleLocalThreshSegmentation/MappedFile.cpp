@@ -0,0 +1,109 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  MappedFile.cpp
+//  Date:   Oct/16/2026
+//
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//********** class MappedFile ****************************************************
+
+MappedFile::MappedFile()
+	: _data(NULL), _size(0), _open(false)
+#ifdef _WIN32
+	, _file(INVALID_HANDLE_VALUE), _mapping(NULL)
+#else
+	, _fd(-1)
+#endif
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+// Maps a file for reading
+//     filename - file to map
+//
+//     returns : false if the file cannot be opened or mapped
+//
+bool MappedFile::open(const string& filename)
+{
+	close();
+#ifdef _WIN32
+	_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+						OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(_file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(_file, &size)){
+		close();
+		return false;
+	}
+	_size = (size_t)size.QuadPart;
+	_open = true;
+	if(_size == 0)
+		return true;
+
+	_mapping = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(_mapping)
+		_data = (const unsigned char*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	_fd = ::open(filename.c_str(), O_RDONLY);
+	if(_fd < 0)
+		return false;
+	struct stat st;
+	if(fstat(_fd, &st) != 0){
+		close();
+		return false;
+	}
+	_size = (size_t)st.st_size;
+	_open = true;
+	if(_size == 0)
+		return true;
+
+	void* data = mmap(NULL, _size, PROT_READ, MAP_SHARED, _fd, 0);
+	if(data != MAP_FAILED)
+		_data = (const unsigned char*)data;
+#endif
+	if(!_data){
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if(_data)
+		UnmapViewOfFile(_data);
+	if(_mapping)
+		CloseHandle(_mapping);
+	if(_file != INVALID_HANDLE_VALUE)
+		CloseHandle(_file);
+	_mapping = NULL;
+	_file = INVALID_HANDLE_VALUE;
+#else
+	if(_data)
+		munmap((void*)_data, _size);
+	if(_fd >= 0)
+		::close(_fd);
+	_fd = -1;
+#endif
+	_data = NULL;
+	_size = 0;
+	_open = false;
+}
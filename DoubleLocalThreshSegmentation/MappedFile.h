@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  MappedFile.h
+//  Date:   Oct/16/2026
+//
+//  Read-only memory mapping of a whole file. Pages are loaded by the OS as
+//  they are touched, so random access into a large file reads only what it
+//  uses and nothing is copied into the process.
+//
+
+#ifndef _MAPPEDFILE_H_
+#define _MAPPEDFILE_H_
+
+#include <cstddef>
+#include <string>
+
+using namespace std;
+
+//********** class MappedFile ****************************************************
+
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	// maps the file; an empty file opens with size() == 0
+	//     returns : false if the file cannot be opened or mapped
+	bool open(const string& filename);
+	void close();
+
+	bool isOpen() const { return _open; }
+	const unsigned char* data() const { return _data; }
+	size_t size() const { return _size; }
+
+private:
+	const unsigned char*	_data;
+	size_t					_size;
+	bool					_open;
+#ifdef _WIN32
+	void*					_file;
+	void*					_mapping;
+#else
+	int						_fd;
+#endif
+
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
+
+#endif
@@ -0,0 +1,386 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Morphology.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <algorithm>
+#include <cstring>
+
+#include "Morphology.h"
+
+//********** buffer growth ***************************************************************************
+
+// resizes a buffer, counting the reallocations
+//     buf          - buffer
+//     size         - new size
+//     allocCounter - if not NULL, incremented when the capacity has to grow
+//
+template<typename T>
+static void growBuffer(vector<T>& buf, size_t size, int* allocCounter)
+{
+	if(size > buf.capacity() && allocCounter)
+		CV_XADD(allocCounter, 1);
+	buf.resize(size);
+}
+
+//********** class MorphRowFilter ********************************************************************
+
+MorphRowFilter::MorphRowFilter()
+	: _width(0), _rows(0), _isMax(false), _identity(255), _top(0), _bottom(0), _ringSize(0), _pad(0),
+	  _pushed(0), _produced(0)
+{
+
+}
+
+// Sets the filter up for an image and an SE
+//     width, rows  - image size
+//     spans        - structuring element
+//     isMax        - dilation instead of erosion
+//     allocCounter - if not NULL, counts the buffer reallocations
+//
+void MorphRowFilter::init(int width, int rows, const vector<MorphSpan>& spans, bool isMax, int* allocCounter)
+{
+	CV_Assert(!spans.empty());
+	_width = width;
+	_rows = rows;
+	_isMax = isMax;
+	_identity = isMax ? 0 : 255;
+	_top = _bottom = _pad = 0;
+	_pushed = _produced = 0;
+	for(size_t i = 0; i < spans.size(); ++i){
+		_top = std::max(_top, -spans[i].dy);
+		_bottom = std::max(_bottom, spans[i].dy);
+		_pad = std::max(_pad, std::max(spans[i].left, spans[i].right));
+	}
+	_ringSize = _top + _bottom + 1;
+
+	// rows past _ringSize are kept for a taller SE, so their lists never reallocate
+	if(_rowSpans.size() < (size_t)_ringSize)
+		growBuffer(_rowSpans, _ringSize, allocCounter);
+	for(int i = 0; i < _ringSize; ++i)
+		_rowSpans[i].clear();
+
+	_left.clear();
+	_right.clear();
+	for(size_t i = 0; i < spans.size(); ++i){
+		CV_Assert(spans[i].left + spans[i].right >= 0);
+		size_t k = 0;
+		while(k < _left.size() && (_left[k] != spans[i].left || _right[k] != spans[i].right))
+			++k;
+		if(k == _left.size()){
+			growBuffer(_left, k+1, allocCounter);
+			growBuffer(_right, k+1, allocCounter);
+			_left[k] = spans[i].left;
+			_right[k] = spans[i].right;
+		}
+		vector<int>& rowSpans = _rowSpans[spans[i].dy + _top];
+		growBuffer(rowSpans, rowSpans.size() + 1, allocCounter);
+		rowSpans.back() = (int)k;
+	}
+
+	growBuffer(_ring, _left.size() * _ringSize * _width, allocCounter);
+	growBuffer(_padded, _width + 2*_pad, allocCounter);
+	std::fill(_padded.begin(), _padded.end(), _identity);
+	growBuffer(_prefix, _padded.size(), allocCounter);
+	growBuffer(_suffix, _padded.size(), allocCounter);
+}
+
+// filters the next input row with every distinct span
+void MorphRowFilter::pushRow(const uchar* src)
+{
+	int slot = _pushed % _ringSize;
+	memcpy(&_padded[_pad], src, _width);
+	for(size_t k = 0; k < _left.size(); ++k)
+		filterRow(_left[k], _right[k], &_ring[(k*_ringSize + slot)*_width]);
+	++_pushed;
+}
+
+// true when the next output row has all its input rows
+bool MorphRowFilter::ready() const
+{
+	return _produced < _rows && _pushed > std::min(_produced + _bottom, _rows - 1);
+}
+
+// combines the horizontal results under the SE into the next output row
+void MorphRowFilter::popRow(uchar* dst)
+{
+	int y = _produced++;
+	bool first = true;
+	for(int dy = -_top; dy <= _bottom; ++dy){
+		int yIn = y + dy;
+		if(yIn < 0 || yIn >= _rows)
+			continue;
+		const vector<int>& rowSpans = _rowSpans[dy + _top];
+		for(size_t i = 0; i < rowSpans.size(); ++i){
+			const uchar* row = &_ring[(rowSpans[i]*_ringSize + yIn % _ringSize)*_width];
+			if(first){
+				memcpy(dst, row, _width);
+				first = false;
+			}
+			else if(_isMax){
+				for(int x = 0; x < _width; ++x)
+					dst[x] = std::max(dst[x], row[x]);
+			}
+			else{
+				for(int x = 0; x < _width; ++x)
+					dst[x] = std::min(dst[x], row[x]);
+			}
+		}
+	}
+	if(first)
+		memset(dst, _identity, _width);
+}
+
+// 1D min/max over [x-left, x+right] of the padded row by van Herk/Gil-Werman:
+// with blocks of the window length, every window is a suffix of one block
+// followed by a prefix of the next one
+void MorphRowFilter::filterRow(int left, int right, uchar* dst)
+{
+	const uchar* p = &_padded[0];
+	int offset = _pad - left;
+	int len = left + right + 1;
+	if(len == 1){
+		memcpy(dst, p + offset, _width);
+		return;
+	}
+
+	int n = offset + _width + len - 1;
+	uchar* g = &_prefix[0];
+	uchar* h = &_suffix[0];
+	if(_isMax){
+		for(int i = 0; i < n; ++i)
+			g[i] = i % len == 0 ? p[i] : std::max(g[i-1], p[i]);
+		h[n-1] = p[n-1];
+		for(int i = n-2; i >= 0; --i)
+			h[i] = (i+1) % len == 0 ? p[i] : std::max(h[i+1], p[i]);
+		for(int x = 0; x < _width; ++x)
+			dst[x] = std::max(h[x + offset], g[x + offset + len - 1]);
+	}
+	else{
+		for(int i = 0; i < n; ++i)
+			g[i] = i % len == 0 ? p[i] : std::min(g[i-1], p[i]);
+		h[n-1] = p[n-1];
+		for(int i = n-2; i >= 0; --i)
+			h[i] = (i+1) % len == 0 ? p[i] : std::min(h[i+1], p[i]);
+		for(int x = 0; x < _width; ++x)
+			dst[x] = std::min(h[x + offset], g[x + offset + len - 1]);
+	}
+}
+
+//********** class MorphPipeline *********************************************************************
+
+// Chain of streaming filters; every row goes through all of them before the
+// next input row is read, so intermediate images never exist in full. The
+// filters and row buffers are those of a workspace
+class MorphPipeline
+{
+public:
+	MorphPipeline(int width, int rows, MorphWorkspace& ws, int* allocCounter)
+		: _width(width), _rows(rows), _written(0), _stageCount(0), _ws(ws), _allocCounter(allocCounter) {}
+
+	void addStage(const vector<MorphSpan>& spans, bool isMax)
+	{
+		size_t k = _stageCount++;
+		if(_ws.filters.size() < _stageCount){
+			growBuffer(_ws.filters, _stageCount, _allocCounter);
+			growBuffer(_ws.rowBufs, _stageCount, _allocCounter);
+		}
+		_ws.filters[k].init(_width, _rows, spans, isMax, _allocCounter);
+		if(_ws.rowBufs[k].size() < (size_t)_width)
+			growBuffer(_ws.rowBufs[k], _width, _allocCounter);
+	}
+
+	// src and dst may be the same image: output rows always trail input rows
+	void run(const Mat& src, Mat& dst)
+	{
+		_written = 0;
+		for(int y = 0; y < _rows; ++y)
+			feed(0, src.ptr<uchar>(y), dst);
+	}
+
+private:
+	int				_width;
+	int				_rows;
+	int				_written;
+	size_t			_stageCount;
+	MorphWorkspace&	_ws;
+	int*			_allocCounter;
+
+	void feed(size_t k, const uchar* row, Mat& dst)
+	{
+		MorphRowFilter& stage = _ws.filters[k];
+		stage.pushRow(row);
+		while(stage.ready()){
+			if(k+1 < _stageCount){
+				stage.popRow(&_ws.rowBufs[k][0]);
+				feed(k+1, &_ws.rowBufs[k][0], dst);
+			}
+			else{
+				stage.popRow(dst.ptr<uchar>(_written++));
+			}
+		}
+	}
+
+	MorphPipeline(const MorphPipeline&);
+	MorphPipeline& operator=(const MorphPipeline&);
+};
+
+// morphological gradient, dilation minus erosion, in one pass
+static void gradientBySpans(const Mat& src, Mat& dst, const vector<MorphSpan>& spans, MorphWorkspace& ws,
+							int* allocCounter)
+{
+	if(ws.filters.size() < 2){
+		growBuffer(ws.filters, 2, allocCounter);
+		growBuffer(ws.rowBufs, 2, allocCounter);
+	}
+	MorphRowFilter& dilation = ws.filters[0];
+	MorphRowFilter& erosion = ws.filters[1];
+	dilation.init(src.cols, src.rows, spans, true, allocCounter);
+	erosion.init(src.cols, src.rows, spans, false, allocCounter);
+	vector<uchar>& erodedRow = ws.rowBufs[0];
+	if(erodedRow.size() < (size_t)src.cols)
+		growBuffer(erodedRow, src.cols, allocCounter);
+
+	int written = 0;
+	for(int y = 0; y < src.rows; ++y){
+		const uchar* srcRow = src.ptr<uchar>(y);
+		dilation.pushRow(srcRow);
+		erosion.pushRow(srcRow);
+		while(dilation.ready()){
+			uchar* dstRow = dst.ptr<uchar>(written++);
+			dilation.popRow(dstRow);
+			erosion.popRow(&erodedRow[0]);
+			for(int x = 0; x < src.cols; ++x)
+				dstRow[x] = dstRow[x] - erodedRow[x];
+		}
+	}
+}
+
+//********** structuring element spans ***************************************************************
+
+// row spans of a row-convex structuring element
+//     se      - structuring element, non-zero where it is set
+//     anchor  - anchor of the SE, (-1, -1) for the center
+//     spans   - receives one span per run of non-zero elements in a row
+//
+void structuringElementSpans(const Mat& se, Point anchor, vector<MorphSpan>& spans)
+{
+	if(anchor.x < 0) anchor.x = se.cols / 2;
+	if(anchor.y < 0) anchor.y = se.rows / 2;
+
+	spans.clear();
+	for(int i = 0; i < se.rows; ++i){
+		const uchar* row = se.ptr<uchar>(i);
+		for(int j = 0; j < se.cols; ){
+			if(!row[j]){
+				++j;
+				continue;
+			}
+			int j0 = j;
+			while(j < se.cols && row[j])
+				++j;
+			MorphSpan span;
+			span.dy = i - anchor.y;
+			span.left = anchor.x - j0;
+			span.right = (j-1) - anchor.x;
+			spans.push_back(span);
+		}
+	}
+}
+
+// row spans of getStructuringElement(MORPH_ELLIPSE, Size(seSize, seSize))
+void ellipseSpans(int seSize, vector<MorphSpan>& spans)
+{
+	Mat se = getStructuringElement(MORPH_ELLIPSE, Size(seSize, seSize));
+	structuringElementSpans(se, Point(-1, -1), spans);
+}
+
+//********** morphology functions ********************************************************************
+
+// Morphological operation with a span structuring element
+//     src   - input 8-bit single-channel image
+//     dst   - output image, may be src
+//     op           - MORPH_ERODE, MORPH_DILATE, MORPH_OPEN, MORPH_CLOSE or MORPH_GRADIENT
+//     spans        - structuring element
+//     ws           - if not NULL, filters and row buffers reused from call to call
+//     allocCounter - if not NULL, counts the reallocations of the buffers of ws
+//
+void morphologyBySpans(InputArray _src, OutputArray _dst, int op, const vector<MorphSpan>& spans,
+					   MorphWorkspace* ws, int* allocCounter)
+{
+	Mat src = _src.getMat();
+	CV_Assert(src.type() == CV_8U);
+	_dst.create(src.size(), CV_8U);
+	Mat dst = _dst.getMat();
+	if(src.empty()) return;
+
+	MorphWorkspace localWs;
+	if(!ws)
+		ws = &localWs;
+	if(op == MORPH_GRADIENT){
+		gradientBySpans(src, dst, spans, *ws, allocCounter);
+		return;
+	}
+
+	MorphPipeline pipeline(src.cols, src.rows, *ws, allocCounter);
+	switch(op){
+		case MORPH_ERODE:
+			pipeline.addStage(spans, false);
+			break;
+		case MORPH_DILATE:
+			pipeline.addStage(spans, true);
+			break;
+		case MORPH_OPEN:
+			pipeline.addStage(spans, false);
+			pipeline.addStage(spans, true);
+			break;
+		case MORPH_CLOSE:
+			pipeline.addStage(spans, true);
+			pipeline.addStage(spans, false);
+			break;
+		default:
+			CV_Assert(!"unsupported morphological operation");
+	}
+	pipeline.run(src, dst);
+}
+
+// Closing, opening and closing with the same SE, fused into a single pass
+//     src          - input 8-bit single-channel image
+//     dst          - output image, may be src
+//     spans        - structuring element
+//     ws           - if not NULL, filters and row buffers reused from call to call
+//     allocCounter - if not NULL, counts the reallocations of the buffers of ws
+//
+void closeOpenCloseBySpans(InputArray _src, OutputArray _dst, const vector<MorphSpan>& spans,
+						   MorphWorkspace* ws, int* allocCounter)
+{
+	Mat src = _src.getMat();
+	CV_Assert(src.type() == CV_8U);
+	_dst.create(src.size(), CV_8U);
+	Mat dst = _dst.getMat();
+	if(src.empty()) return;
+
+	MorphWorkspace localWs;
+	MorphPipeline pipeline(src.cols, src.rows, ws ? *ws : localWs, allocCounter);
+	const bool stages[] = {true, false, false, true, true, false};
+	for(int i = 0; i < 6; ++i)
+		pipeline.addStage(spans, stages[i]);
+	pipeline.run(src, dst);
+}
+
+// morphologyEx with getStructuringElement(MORPH_ELLIPSE, Size(seSize, seSize))
+void ellipseMorphologyEx(InputArray src, OutputArray dst, int op, int seSize)
+{
+	vector<MorphSpan> spans;
+	ellipseSpans(seSize, spans);
+	morphologyBySpans(src, dst, op, spans);
+}
+
+// close-open-close with getStructuringElement(MORPH_ELLIPSE, Size(seSize, seSize))
+void ellipseCloseOpenClose(InputArray src, OutputArray dst, int seSize)
+{
+	vector<MorphSpan> spans;
+	ellipseSpans(seSize, spans);
+	closeOpenCloseBySpans(src, dst, spans);
+}
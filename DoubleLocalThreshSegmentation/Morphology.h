@@ -0,0 +1,112 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  Morphology.h
+//  Date:   Oct/16/2026
+//
+//  Grayscale morphology for 8-bit single-channel images with structuring
+//  elements given as one horizontal span per row, e.g. MORPH_ELLIPSE.
+//
+//  Each row span is a 1D min/max filter computed with the van Herk/Gil-Werman
+//  algorithm (3 comparisons per pixel whatever the span length), so the cost
+//  per pixel grows with the SE height only, not with its area. Results are
+//  identical to cv::morphologyEx with the default constant border. Composite
+//  operations stream rows through all passes, so close-open-close reads and
+//  writes the frame once instead of six times.
+//
+
+#ifndef _MORPHOLOGY_H_
+#define _MORPHOLOGY_H_
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+using namespace std;
+using namespace cv;
+
+//********** structuring element spans ***************************************************************
+
+// pixels (x-left .. x+right, y+dy) of the SE anchored at (x, y)
+struct MorphSpan
+{
+	int dy;
+	int left;
+	int right;
+};
+
+// row spans of an arbitrary row-convex structuring element
+void structuringElementSpans(const Mat& se, Point anchor, vector<MorphSpan>& spans);
+
+// row spans of getStructuringElement(MORPH_ELLIPSE, Size(seSize, seSize))
+void ellipseSpans(int seSize, vector<MorphSpan>& spans);
+
+//********** class MorphRowFilter ********************************************************************
+
+// Streaming erosion (min) or dilation (max) of an image with a span SE.
+// Input rows are pushed in order and filtered horizontally once per distinct
+// span; an output row can be popped as soon as every row under the SE has
+// arrived. Pixels outside the image are ignored, which is what the default
+// constant border of cv::erode/cv::dilate amounts to.
+class MorphRowFilter
+{
+public:
+	MorphRowFilter();
+
+	// sets the filter up for another image or SE; the buffers only grow, and
+	// each time they do *allocCounter, if given, is incremented
+	void init(int width, int rows, const vector<MorphSpan>& spans, bool isMax, int* allocCounter = 0);
+
+	void pushRow(const uchar* src);
+	bool ready() const;
+	void popRow(uchar* dst);
+
+private:
+	int				_width;
+	int				_rows;
+	bool			_isMax;
+	uchar			_identity;
+	int				_top;
+	int				_bottom;
+	int				_ringSize;
+	int				_pad;
+	vector<int>		_left;			// distinct spans
+	vector<int>		_right;
+	vector<vector<int>> _rowSpans;	// distinct spans of each SE row, indexed by dy + _top
+	vector<uchar>	_ring;			// span x ring slot x width horizontal results
+	vector<uchar>	_padded;
+	vector<uchar>	_prefix;
+	vector<uchar>	_suffix;
+	int				_pushed;
+	int				_produced;
+
+	void filterRow(int left, int right, uchar* dst);
+};
+
+//********** struct MorphWorkspace *******************************************************************
+
+// filters and the row buffers between them, kept from call to call so that
+// images no wider than the last ones and the same SEs allocate nothing
+struct MorphWorkspace
+{
+	vector<MorphRowFilter>	filters;
+	vector<vector<uchar>>	rowBufs;
+};
+
+//********** morphology functions ********************************************************************
+
+// same as morphologyEx(src, dst, op, se) for MORPH_ERODE, MORPH_DILATE,
+// MORPH_OPEN, MORPH_CLOSE and MORPH_GRADIENT; src may be dst. Without ws
+// the filters are set up for this call only
+void morphologyBySpans(InputArray src, OutputArray dst, int op, const vector<MorphSpan>& spans,
+					   MorphWorkspace* ws = 0, int* allocCounter = 0);
+
+// closing, opening, then closing again with one SE, in a single pass
+void closeOpenCloseBySpans(InputArray src, OutputArray dst, const vector<MorphSpan>& spans,
+						   MorphWorkspace* ws = 0, int* allocCounter = 0);
+
+// shortcuts for an elliptical SE of size seSize x seSize
+void ellipseMorphologyEx(InputArray src, OutputArray dst, int op, int seSize);
+void ellipseCloseOpenClose(InputArray src, OutputArray dst, int seSize);
+
+#endif
@@ -0,0 +1,386 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  ObjectList.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "ObjectList.h"
+
+#ifdef _WIN32
+#define fseek64 _fseeki64
+#define ftell64 _ftelli64
+#else
+#define fseek64 fseeko
+#define ftell64 ftello
+#endif
+
+//********** file layout *********************************************************
+
+static const char containerMagic[8] = { 'D', 'L', 'T', 'S', 'O', 'B', 'J', '1' };
+static const char indexMagic[8] = { 'D', 'L', 'T', 'S', 'I', 'D', 'X', '1' };
+static const uint32_t formatVersion = 1;
+static const uint32_t recordMagic = 0x4D415246;		// "FRAM"
+
+static const size_t fileHeaderBytes = 16;
+static const size_t recordHeaderBytes = 32;
+static const size_t objectHeaderBytes = 64;
+static const size_t runBytes = 12;
+static const size_t indexEntryBytes = 16;
+
+static_assert(sizeof(RLERun) == runBytes, "runs are copied to and from the file as they are");
+
+template<class T> static void put(vector<uchar>& buf, T value)
+{
+	size_t pos = buf.size();
+	buf.resize(pos + sizeof(T));
+	memcpy(&buf[pos], &value, sizeof(T));
+}
+
+// reads a value at p, which need not be aligned
+template<class T> static T get(const uchar* p)
+{
+	T value;
+	memcpy(&value, p, sizeof(T));
+	return value;
+}
+
+static void putFileHeader(vector<uchar>& buf, const char* magic)
+{
+	buf.insert(buf.end(), magic, magic + 8);
+	put<uint32_t>(buf, formatVersion);
+	put<uint32_t>(buf, 0);
+}
+
+static bool checkFileHeader(const uchar* p, size_t size, const char* magic)
+{
+	return size >= fileHeaderBytes && memcmp(p, magic, 8) == 0 && get<uint32_t>(p + 8) == formatVersion;
+}
+
+// Opens a file for appending after a header, writing the header if the file is new
+//     returns : the file, NULL if it cannot be opened or has another header
+//
+static FILE* openAppend(const string& filename, const char* magic, uint64* size)
+{
+	FILE* file = fopen(filename.c_str(), "r+b");
+	if(!file){
+		file = fopen(filename.c_str(), "w+b");
+		if(!file)
+			return NULL;
+	}
+
+	fseek64(file, 0, SEEK_END);
+	*size = (uint64)ftell64(file);
+	if(*size == 0){
+		vector<uchar> header;
+		putFileHeader(header, magic);
+		if(fwrite(&header[0], 1, header.size(), file) != header.size()){
+			fclose(file);
+			return NULL;
+		}
+		*size = header.size();
+		return file;
+	}
+
+	uchar header[fileHeaderBytes];
+	fseek64(file, 0, SEEK_SET);
+	if(*size < fileHeaderBytes || fread(header, 1, fileHeaderBytes, file) != fileHeaderBytes ||
+	   !checkFileHeader(header, fileHeaderBytes, magic)){
+		fclose(file);
+		return NULL;
+	}
+	fseek64(file, 0, SEEK_END);
+	return file;
+}
+
+//********** object encoding *****************************************************
+
+// Appends the object part of a record
+//     objects - objects of a frame
+//     buf     - buffer to append to
+//
+void encodeObjects(const vector<SegmentedObject>& objects, vector<uchar>& buf)
+{
+	for(size_t i = 0; i < objects.size(); ++i){
+		const SegmentedObject& object = objects[i];
+		put<int32_t>(buf, object.boundingBox.x);
+		put<int32_t>(buf, object.boundingBox.y);
+		put<int32_t>(buf, object.boundingBox.width);
+		put<int32_t>(buf, object.boundingBox.height);
+		put<int64>(buf, object.area);
+		put<double>(buf, object.mean);
+		put<double>(buf, object.variance);
+		put<float>(buf, object.orientedBox.center.x);
+		put<float>(buf, object.orientedBox.center.y);
+		put<float>(buf, object.orientedBox.size.width);
+		put<float>(buf, object.orientedBox.size.height);
+		put<float>(buf, object.orientedBox.angle);
+
+		const vector<RLERun>& runs = object.region.runs();
+		put<uint32_t>(buf, (uint32_t)runs.size());
+		for(size_t j = 0; j < runs.size(); ++j){
+			put<int32_t>(buf, runs[j].y);
+			put<int32_t>(buf, runs[j].x0);
+			put<int32_t>(buf, runs[j].x1);
+		}
+	}
+}
+
+// Decodes the object part of a record
+//     data    - first object
+//     size    - bytes from data to the end of the record
+//     count   - number of objects
+//     objects - receives the objects
+//
+//     returns : false if the objects do not fit in size bytes
+//
+bool decodeObjects(const uchar* data, size_t size, size_t count, vector<SegmentedObject>& objects)
+{
+	const uchar* p = data;
+	const uchar* end = data + size;
+	objects.clear();
+	if(size / objectHeaderBytes < count)
+		return false;
+	vector<RLERun> runs;
+	objects.resize(count);
+	for(size_t k = 0; k < count; ++k){
+		if((size_t)(end - p) < objectHeaderBytes){
+			objects.clear();
+			return false;
+		}
+		SegmentedObject& object = objects[k];
+		object.boundingBox = Rect(get<int32_t>(p), get<int32_t>(p + 4), get<int32_t>(p + 8), get<int32_t>(p + 12));
+		object.area = get<int64>(p + 16);
+		object.mean = get<double>(p + 24);
+		object.variance = get<double>(p + 32);
+		object.orientedBox.center = Point2f(get<float>(p + 40), get<float>(p + 44));
+		object.orientedBox.size = Size2f(get<float>(p + 48), get<float>(p + 52));
+		object.orientedBox.angle = get<float>(p + 56);
+		uint32_t runCount = get<uint32_t>(p + 60);
+		p += objectHeaderBytes;
+
+		if((uint64)(end - p) / runBytes < runCount){
+			objects.clear();
+			return false;
+		}
+		runs.resize(runCount);
+		if(runCount)
+			memcpy(&runs[0], p, runCount * runBytes);
+		object.region.assign(runs);
+		p += runCount * runBytes;
+	}
+	return true;
+}
+
+//********** class ObjectListWriter **********************************************
+
+ObjectListWriter::ObjectListWriter()
+	: _file(NULL), _indexFile(NULL), _offset(0)
+{
+
+}
+
+ObjectListWriter::~ObjectListWriter()
+{
+	close();
+}
+
+// Opens a container and its index for appending
+//     filename - container file, the index is filename + ".idx"
+//
+//     returns : false if either file cannot be created or is not of this format
+//
+bool ObjectListWriter::open(const string& filename)
+{
+	close();
+	uint64 indexSize;
+	_file = openAppend(filename, containerMagic, &_offset);
+	_indexFile = _file ? openAppend(filename + ".idx", indexMagic, &indexSize) : NULL;
+	if(!_indexFile){
+		close();
+		return false;
+	}
+
+	// the reader skips index entries whose record was cut off, so a partial
+	// entry at the end is all that needs cleaning up
+	uint64 partial = (indexSize - fileHeaderBytes) % indexEntryBytes;
+	if(partial)
+		fseek64(_indexFile, -(int64)partial, SEEK_END);
+	return true;
+}
+
+void ObjectListWriter::close()
+{
+	if(_file)
+		fclose(_file);
+	if(_indexFile)
+		fclose(_indexFile);
+	_file = NULL;
+	_indexFile = NULL;
+}
+
+void ObjectListWriter::flush()
+{
+	if(_file)
+		fflush(_file);
+	if(_indexFile)
+		fflush(_indexFile);
+}
+
+// Appends one frame record and its index entry
+//     frameId   - id of the frame, e.g. its position in the stream
+//     frameSize - size of the frame
+//     objects   - objects of the frame
+//
+//     returns : false on a write error
+//
+bool ObjectListWriter::write(uint64 frameId, Size frameSize, const vector<SegmentedObject>& objects)
+{
+	if(!_file)
+		return false;
+
+	_buf.clear();
+	put<uint32_t>(_buf, recordMagic);
+	put<uint32_t>(_buf, (uint32_t)objects.size());
+	put<uint64>(_buf, frameId);
+	put<int32_t>(_buf, frameSize.width);
+	put<int32_t>(_buf, frameSize.height);
+	put<uint64>(_buf, 0);	// payload size, filled in below
+
+	encodeObjects(objects, _buf);
+	uint64 payload = _buf.size() - recordHeaderBytes;
+	memcpy(&_buf[24], &payload, sizeof(payload));
+
+	// the record goes first, so an index entry never points past the data
+	uint64 entry[2] = { frameId, _offset };
+	if(fwrite(&_buf[0], 1, _buf.size(), _file) != _buf.size() ||
+	   fwrite(entry, 1, indexEntryBytes, _indexFile) != indexEntryBytes)
+		return false;
+	_offset += _buf.size();
+	return true;
+}
+
+//********** class ObjectListReader **********************************************
+
+ObjectListReader::ObjectListReader()
+	: _sortedIds(true)
+{
+
+}
+
+// Maps a container and loads its index
+//     filename - container file, the index is filename + ".idx"
+//
+//     returns : false if the container cannot be mapped or is not of this format
+//
+bool ObjectListReader::open(const string& filename)
+{
+	close();
+	if(!_file.open(filename) || !checkFileHeader(_file.data(), _file.size(), containerMagic)){
+		close();
+		return false;
+	}
+
+	// the index lists the records in file order; entries of records that
+	// never made it to the disk are skipped, and records whose entries did
+	// not, e.g. after an interrupted writer, are found by scanning the gaps
+	MappedFile indexFile;
+	size_t count = 0;
+	if(indexFile.open(filename + ".idx") && checkFileHeader(indexFile.data(), indexFile.size(), indexMagic))
+		count = (indexFile.size() - fileHeaderBytes) / indexEntryBytes;
+
+	uint64 end = fileHeaderBytes;
+	for(size_t i = 0; i <= count; ++i){
+		uint64 next = _file.size();
+		if(i < count)
+			next = get<uint64>(indexFile.data() + fileHeaderBytes + i*indexEntryBytes + 8);
+		if(next < end)
+			continue;
+
+		uint64 frameId, recordEnd;
+		while(end < next && recordAt(end, &frameId, &recordEnd) && recordEnd <= next){
+			IndexEntry entry = { frameId, end };
+			_index.push_back(entry);
+			end = recordEnd;
+		}
+
+		if(i < count && recordAt(next, &frameId, &recordEnd) &&
+		   frameId == get<uint64>(indexFile.data() + fileHeaderBytes + i*indexEntryBytes)){
+			IndexEntry entry = { frameId, next };
+			_index.push_back(entry);
+			end = recordEnd;
+		}
+	}
+
+	for(size_t i = 1; i < _index.size() && _sortedIds; ++i)
+		_sortedIds = _index[i-1].frameId < _index[i].frameId;
+	return true;
+}
+
+void ObjectListReader::close()
+{
+	_file.close();
+	_index.clear();
+	_sortedIds = true;
+}
+
+// Checks the record at an offset
+//     frameId - receives the id of its frame
+//     end     - receives the offset right after it
+//
+//     returns : false if no complete record starts there
+//
+bool ObjectListReader::recordAt(uint64 offset, uint64* frameId, uint64* end) const
+{
+	uint64 size = _file.size();
+	if(offset < fileHeaderBytes || offset > size || size - offset < recordHeaderBytes)
+		return false;
+	const uchar* p = _file.data() + offset;
+	uint64 payload = get<uint64>(p + 24);
+	if(get<uint32_t>(p) != recordMagic || payload > size - offset - recordHeaderBytes)
+		return false;
+	*frameId = get<uint64>(p + 8);
+	*end = offset + recordHeaderBytes + payload;
+	return true;
+}
+
+int ObjectListReader::findFrame(uint64 frameId) const
+{
+	if(_sortedIds){
+		size_t lo = 0, hi = _index.size();
+		while(lo < hi){
+			size_t mid = (lo + hi) / 2;
+			if(_index[mid].frameId < frameId) lo = mid + 1; else hi = mid;
+		}
+		return lo < _index.size() && _index[lo].frameId == frameId ? (int)lo : -1;
+	}
+	for(size_t i = 0; i < _index.size(); ++i){
+		if(_index[i].frameId == frameId)
+			return (int)i;
+	}
+	return -1;
+}
+
+// Decodes the objects of a frame
+//     i         - position of the frame in the container
+//     objects   - receives the objects
+//     frameSize - if not NULL, receives the size of the frame
+//
+//     returns : false if the record is damaged
+//
+bool ObjectListReader::readFrame(size_t i, vector<SegmentedObject>& objects, Size* frameSize) const
+{
+	objects.clear();
+	if(i >= _index.size())
+		return false;
+
+	// recordAt has checked the header when the index was loaded
+	const uchar* p = _file.data() + _index[i].offset;
+	uint32_t count = get<uint32_t>(p + 4);
+	if(frameSize)
+		*frameSize = Size(get<int32_t>(p + 16), get<int32_t>(p + 20));
+	return decodeObjects(p + recordHeaderBytes, get<uint64>(p + 24), count, objects);
+}
@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  ObjectList.h
+//  Date:   Oct/16/2026
+//
+//  Per-object segmentation results and a binary container for them.
+//
+//  A container holds one record per frame, appended as frames are done:
+//  the frame id and size, then each object's bounding box, area, gray
+//  level statistics, oriented box and mask runs. A sidecar index file
+//  (<container>.idx) lists the id and offset of every record, so a reader
+//  maps the container and jumps to any frame without parsing the ones
+//  before it. Numbers are stored in the byte order of the writer
+//  (little-endian on every platform we build for).
+//
+//  Layout, all integers unsigned unless noted:
+//      container  "DLTSOBJ1", u32 version, u32 reserved, then records
+//      record     u32 'FRAM', u32 objects, u64 frame id, i32 width,
+//                 i32 height, u64 bytes of the objects that follow
+//      object     i32 x, y, width, height, i64 area, f64 mean, variance,
+//                 f32 center x, center y, width, height, angle,
+//                 u32 runs, then runs x (i32 y, x0, x1)
+//      index      "DLTSIDX1", u32 version, u32 reserved, then per record
+//                 u64 frame id, u64 offset
+//
+
+#ifndef _OBJECTLIST_H_
+#define _OBJECTLIST_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "RLERegion.h"
+#include "MappedFile.h"
+
+using namespace std;
+using namespace cv;
+
+//********** struct SegmentedObject **********************************************
+
+// one object of a segmented frame, in frame coordinates
+struct SegmentedObject
+{
+	RLERegion	region;			// mask pixels enclosed by the object's outer contour
+	Rect		boundingBox;	// of region
+	int64		area;			// pixel count of region
+	double		mean;			// gray level mean of the input over region
+	double		variance;		// sample variance of the same
+	RotatedRect	orientedBox;	// principal axis box of the contour, see orientedBoundingBox
+};
+
+//********** object encoding *****************************************************
+
+// the object part of a record, for passing objects on other than in a container
+void encodeObjects(const vector<SegmentedObject>& objects, vector<uchar>& buf);
+bool decodeObjects(const uchar* data, size_t size, size_t count, vector<SegmentedObject>& objects);
+
+//********** class ObjectListWriter **********************************************
+
+// Appends frame records to a container and its index
+class ObjectListWriter
+{
+public:
+	ObjectListWriter();
+	~ObjectListWriter();
+
+	// opens a container for appending, creating it if it does not exist
+	//     returns : false if it cannot be created or is not a container
+	bool open(const string& filename);
+	void close();
+	bool isOpen() const { return _file != NULL; }
+
+	// appends the objects of one frame
+	//     returns : false on a write error
+	bool write(uint64 frameId, Size frameSize, const vector<SegmentedObject>& objects);
+
+	// pushes the buffered records and index entries to the files
+	void flush();
+
+private:
+	FILE*			_file;
+	FILE*			_indexFile;
+	uint64			_offset;	// end of the last record
+	vector<uchar>	_buf;
+
+	ObjectListWriter(const ObjectListWriter&);
+	ObjectListWriter& operator=(const ObjectListWriter&);
+};
+
+//********** class ObjectListReader **********************************************
+
+// Random access to the frames of a memory-mapped container
+class ObjectListReader
+{
+public:
+	ObjectListReader();
+
+	// maps a container; records past the end of the index, e.g. after a
+	// writer was interrupted, are found by scanning from the last indexed one
+	//     returns : false if it cannot be mapped or is not a container
+	bool open(const string& filename);
+	void close();
+
+	size_t frameCount() const { return _index.size(); }
+	uint64 frameId(size_t i) const { return _index[i].frameId; }
+
+	// position of the frame with the given id, -1 if there is none
+	int findFrame(uint64 frameId) const;
+
+	// decodes frame i
+	//     frameSize - if not NULL, receives the size of the frame
+	//     returns   : false if the record is damaged
+	bool readFrame(size_t i, vector<SegmentedObject>& objects, Size* frameSize = NULL) const;
+
+private:
+	struct IndexEntry
+	{
+		uint64 frameId;
+		uint64 offset;
+	};
+
+	MappedFile			_file;
+	vector<IndexEntry>	_index;
+	bool				_sortedIds;
+
+	bool recordAt(uint64 offset, uint64* frameId, uint64* end) const;
+};
+
+#endif
@@ -0,0 +1,339 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  ParameterSweep.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <exception>
+#include <tuple>
+
+#include "ParameterSweep.h"
+#include "WorkStealingPool.h"
+
+//********** struct ParameterGrid ************************************************
+
+ParameterGrid::ParameterGrid(const FGParameters& p)
+	: minArea(1, p.minArea), maxArea(1, p.maxArea), minVar(1, p.minVar),
+	  pHigh(1, p.pHigh), pLow(1, p.pLow), theta(1, p.theta), nbins(1, p.nbins),
+	  gradSESize(1, p.gradSESize), areaSESize(1, p.areaSESize), postSESize(1, p.postSESize)
+{
+
+}
+
+vector<FGParameters> ParameterGrid::points() const
+{
+	vector<FGParameters> result;
+	FGParameters p;
+	for(size_t i0 = 0; i0 < minArea.size(); ++i0){ p.minArea = minArea[i0];
+	for(size_t i1 = 0; i1 < maxArea.size(); ++i1){ p.maxArea = maxArea[i1];
+	for(size_t i2 = 0; i2 < minVar.size(); ++i2){ p.minVar = minVar[i2];
+	for(size_t i3 = 0; i3 < pHigh.size(); ++i3){ p.pHigh = pHigh[i3];
+	for(size_t i4 = 0; i4 < pLow.size(); ++i4){ p.pLow = pLow[i4];
+	for(size_t i5 = 0; i5 < theta.size(); ++i5){ p.theta = theta[i5];
+	for(size_t i6 = 0; i6 < nbins.size(); ++i6){ p.nbins = nbins[i6];
+	for(size_t i7 = 0; i7 < gradSESize.size(); ++i7){ p.gradSESize = gradSESize[i7];
+	for(size_t i8 = 0; i8 < areaSESize.size(); ++i8){ p.areaSESize = areaSESize[i8];
+	for(size_t i9 = 0; i9 < postSESize.size(); ++i9){ p.postSESize = postSESize[i9];
+		result.push_back(p);
+	}}}}}}}}}}
+	return result;
+}
+
+//********** class ParameterSweep ************************************************
+
+ParameterSweep::ParameterSweep(const FGExtraction& settings, int threads)
+	: _settings(new FGExtraction(settings)), _threads(threads)
+{
+	// the sweep always follows the fused region-local path, whose masks are
+	// those of every other path
+	_settings->_ws = FGExtraction::Workspace();
+	_settings->_temporalMode = false;
+	_settings->resetTemporalState();
+	_settings->clearFrameCache();
+	_settings->_stats = NULL;
+	_settings->_trace = NULL;
+	_stats = SweepStats();
+}
+
+ParameterSweep::~ParameterSweep()
+{
+	for(size_t i = 0; i < _engines.size(); ++i)
+		delete _engines[i];
+	delete _settings;
+}
+
+// Segments every image for every grid point
+//     inImgs   - input images, grayscale or color
+//     points   - parameters to segment with
+//     onResult - receives each mask as soon as it is done, an empty one
+//                for an image that is empty or that a stage fails on
+//
+void ParameterSweep::run(const vector<Mat>& inImgs, const vector<FGParameters>& points, const ResultCallback& onResult)
+{
+	int64 start = getTickCount();
+	_stats = SweepStats();
+	_stats.points = points.size();
+	_stats.images = inImgs.size();
+
+	// points that localize alike form a group
+	typedef std::tuple<int, double, double> GroupKey;
+	map<GroupKey, size_t> groupIndex;
+	vector<Group> groups;
+	for(size_t i = 0; i < points.size(); ++i){
+		GroupKey key(points[i].gradSESize, points[i].minArea, points[i].maxArea);
+		map<GroupKey, size_t>::iterator it = groupIndex.find(key);
+		if(it == groupIndex.end()){
+			it = groupIndex.insert(make_pair(key, groups.size())).first;
+			groups.push_back(Group());
+		}
+		groups[it->second].points.push_back(i);
+	}
+
+	WorkStealingPool pool(_threads);
+	for(size_t k = 0; k < inImgs.size(); ++k){
+		if(inImgs[k].empty()){
+			for(size_t i = 0; i < points.size(); ++i)
+				onResult(i, k, Mat());
+			continue;
+		}
+		Mat inImg;
+		if(inImgs[k].channels() == 1)
+			inImg = inImgs[k];
+		else
+			cvtColor(inImgs[k], inImg, COLOR_BGR2GRAY);
+
+		// localize once per group, then threshold each region once per
+		// threshold its points map it to. A throwing stage, e.g. on an
+		// unsupported depth, fails the group, whose points get empty masks;
+		// the engine it held is not reused
+		for(size_t g = 0; g < groups.size(); ++g){
+			Group* group = &groups[g];
+			group->regions.clear();
+			group->failed = false;
+			pool.submit([this, &pool, &inImg, &points, group]() {
+				try{
+					localizeGroup(inImg, points, *group);
+				}
+				catch(const std::exception&){
+					// cv::Exception included
+					group->failed = true;
+					return;
+				}
+				for(size_t r = 0; r < group->regions.size(); ++r){
+					Region* region = &group->regions[r];
+					pool.submit([this, &inImg, &points, group, region]() {
+						try{
+							thresholdRegion(inImg, points, *group, *region);
+						}
+						catch(const std::exception&){
+							region->failed = true;
+						}
+					});
+				}
+			});
+		}
+		pool.wait();
+
+		for(size_t g = 0; g < groups.size(); ++g){
+			Group& group = groups[g];
+			for(size_t r = 0; r < group.regions.size(); ++r)
+				group.failed = group.failed || group.regions[r].failed;
+			_stats.localizations += 1;
+			_stats.regions += group.regions.size();
+			_stats.unsharedMasks += 2 * group.regions.size() * group.points.size();
+			for(size_t r = 0; r < group.regions.size(); ++r)
+				_stats.thresholdMasks += group.regions[r].levelHists.size();
+		}
+
+		// the points themselves only merge what the groups computed
+		for(size_t g = 0; g < groups.size(); ++g){
+			const Group* group = &groups[g];
+			for(size_t i = 0; i < group->points.size(); ++i){
+				size_t point = group->points[i];
+				pool.submit([this, &inImg, &points, &onResult, group, point, k]() {
+					Mat fgImg;
+					try{
+						if(!group->failed)
+							segmentPoint(inImg, points[point], *group, fgImg);
+					}
+					catch(const std::exception&){
+						fgImg.release();
+					}
+					onResult(point, k, fgImg);
+				});
+			}
+		}
+		pool.wait();
+	}
+
+	_stats.seconds = (getTickCount() - start) / getTickFrequency();
+}
+
+void ParameterSweep::run(const vector<Mat>& inImgs, const vector<FGParameters>& points, vector<vector<Mat>>& fgImgs)
+{
+	// every mask has its own slot, so no lock is needed
+	fgImgs.assign(points.size(), vector<Mat>(inImgs.size()));
+	run(inImgs, points, [&fgImgs](size_t point, size_t image, const Mat& fgImg) {
+		fgImgs[point][image] = fgImg;
+	});
+}
+
+// Returns an idle engine set to the given parameters, creating one if none is idle
+FGExtraction* ParameterSweep::acquireEngine(const FGParameters& p)
+{
+	FGExtraction* engine = NULL;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if(!_idleEngines.empty()){
+			engine = _idleEngines.back();
+			_idleEngines.pop_back();
+		}
+		else{
+			engine = new FGExtraction(*_settings);
+			_engines.push_back(engine);
+		}
+	}
+	engine->setParameters(p.minArea, p.maxArea, p.minVar, p.pHigh, p.pLow, p.theta, p.nbins,
+						  p.gradSESize, p.areaSESize, p.postSESize);
+	return engine;
+}
+
+void ParameterSweep::releaseEngine(FGExtraction* engine)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_idleEngines.push_back(engine);
+}
+
+// Coarse localization of a group and the parts of its regions that do not
+// depend on the thresholds
+//     inImg  - input grayscale image
+//     points - all grid points
+//     group  - receives its regions
+//
+void ParameterSweep::localizeGroup(const Mat& inImg, const vector<FGParameters>& points, Group& group)
+{
+	FGExtraction* engine = acquireEngine(points[group.points[0]]);
+	vector<vector<Point>> contours;
+	engine->coarseLocalize(inImg, contours);
+	vector<RotatedRect>& orientedBoxes = engine->_ws.orientedBoxes;
+	orientedBoundingBoxes(contours, orientedBoxes, engine->_ws.contourPoints);
+
+	group.regions.assign(orientedBoxes.size(), Region());
+	for(size_t i = 0; i < orientedBoxes.size(); ++i){
+		Region& region = group.regions[i];
+		RotatedRect regionBox;
+		region.window = engine->localRegionWindow(orientedBoxes[i], inImg.size(), regionBox);
+		region.thresh = region.u = 0;
+		region.failed = false;
+		if(region.window.area() == 0)
+			continue;
+
+		// the "local region" mask in window coordinates, as segmentLocalRegion draws it
+		region.mask.create(region.window.size(), CV_8U);
+		region.mask.setTo(0);
+		regionBox.center.x -= region.window.x;
+		regionBox.center.y -= region.window.y;
+		ellipse(region.mask, regionBox, Scalar(255), -1);
+		region.maskBits.fromMat(region.mask);
+	}
+	releaseEngine(engine);
+}
+
+// Otsu threshold of a region and the gray level histogram of its filtered
+// mask at every threshold the points of its group use
+//     inImg  - input grayscale image
+//     points - all grid points
+//     group  - group of the region
+//     region - receives the threshold and the histograms
+//
+void ParameterSweep::thresholdRegion(const Mat& inImg, const vector<FGParameters>& points, const Group& group,
+									 Region& region)
+{
+	if(region.window.area() == 0)
+		return;
+	Mat inROI = inImg(region.window);
+	region.thresh = _settings->getOtsuThreshold(inROI, 0, 255, &region.u, region.mask);
+
+	for(size_t i = 0; i < group.points.size(); ++i){
+		const FGParameters& p = points[group.points[i]];
+		region.levelHists[shiftedThreshold(region, p.pHigh)];
+		region.levelHists[shiftedThreshold(region, p.pLow)];
+	}
+
+	// threshold the masked input as doubleLocalThreshold does, filter, count
+	Size size = region.window.size();
+	Mat rawImg(size, CV_8U), filteredImg(size, CV_8U);
+	for(map<int, vector<int>>::iterator it = region.levelHists.begin(); it != region.levelHists.end(); ++it){
+		int thresh = it->first;
+		for(int y = 0; y < size.height; ++y){
+			const uchar* in = inROI.ptr<uchar>(y);
+			const uchar* roi = region.mask.ptr<uchar>(y);
+			uchar* raw = rawImg.ptr<uchar>(y);
+			for(int x = 0; x < size.width; ++x)
+				raw[x] = (in[x] & roi[x]) > thresh ? 255 : 0;
+		}
+		_settings->medianFilter(rawImg, filteredImg);
+
+		vector<int>& hist = it->second;
+		hist.assign(256, 0);
+		for(int y = 0; y < size.height; ++y){
+			const uchar* in = inROI.ptr<uchar>(y);
+			const uchar* filtered = filteredImg.ptr<uchar>(y);
+			for(int x = 0; x < size.width; ++x)
+				hist[in[x]] += filtered[x] != 0;
+		}
+	}
+}
+
+// Segments an image for one point from the shared results of its group
+//     inImg - input grayscale image
+//     p     - parameters of the point
+//     group - group of the point, localized and thresholded
+//     fgImg - receives the object mask
+//
+void ParameterSweep::segmentPoint(const Mat& inImg, const FGParameters& p, const Group& group, Mat& fgImg)
+{
+	FGExtraction* engine = acquireEngine(p);
+	FGExtraction::Workspace& ws = engine->_ws;
+	size_t n = group.regions.size();
+	ws.windows.resize(n);
+	ws.regionMasks.resize(n);
+
+	// the level histograms binned as ratioHistLUT bins them
+	int nbins = p.nbins;
+	vector<int> binCounts(2 * (nbins + 1));
+	int* highHist = &binCounts[0];
+	int* lowHist = highHist + nbins + 1;
+	for(size_t i = 0; i < n; ++i){
+		const Region& region = group.regions[i];
+		ws.windows[i] = region.window;
+		if(region.window.area() == 0){
+			ws.regionMasks[i].create(Size());
+			continue;
+		}
+		const vector<int>& highLevels = region.levelHists.find(shiftedThreshold(region, p.pHigh))->second;
+		const vector<int>& lowLevels = region.levelHists.find(shiftedThreshold(region, p.pLow))->second;
+		std::fill(binCounts.begin(), binCounts.end(), 0);
+		for(int level = 0; level < 256; ++level){
+			int bin = engine->_binIndex[level];
+			highHist[bin] += highLevels[level];
+			lowHist[bin] += lowLevels[level];
+		}
+
+		uchar lut[256];
+		engine->ratioLUT(highHist, lowHist, lut);
+		ws.regionMasks[i].create(region.window.size(), &engine->_allocCount);
+		FGExtraction::orByLUT(inImg(region.window), lut, region.maskBits, ws.regionMasks[i]);
+	}
+
+	Mat& mergedImg = engine->workBuffer(ws.fgImg, inImg.size(), CV_8U);
+	engine->mergeLocalRegions(ws.windows, ws.regionMasks, mergedImg);
+	engine->finishForeground(inImg, mergedImg, fgImg);
+	releaseEngine(engine);
+}
+
+// threshold of doubleLocalThreshold for the high or low parameter p
+int ParameterSweep::shiftedThreshold(const Region& region, double p)
+{
+	return region.thresh - int(p*(region.thresh - region.u));
+}
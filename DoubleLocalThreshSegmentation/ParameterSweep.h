@@ -0,0 +1,150 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  ParameterSweep.h
+//  Date:   Oct/16/2026
+//
+//  Segments images for every point of a parameter grid without redoing the
+//  stages the points share. Points with the same gradient SE and area
+//  limits share the coarse localization, the local regions and their Otsu
+//  thresholds; points that map a region to the same integer threshold share
+//  its thresholded, median filtered mask. Per point only the ratio LUT, the
+//  region masks and the final stages are computed, on all threads at once.
+//  The masks are those of FGExtraction with the same parameters.
+//
+
+#ifndef _PARAMETERSWEEP_H_
+#define _PARAMETERSWEEP_H_
+
+#include <map>
+#include <vector>
+#include <mutex>
+#include <functional>
+
+#include <opencv2/core/core.hpp>
+
+#include "FGExtraction.h"
+
+using namespace std;
+using namespace cv;
+
+//********** struct FGParameters *************************************************
+
+// the parameters of the FGExtraction constructor
+struct FGParameters
+{
+	double	minArea;
+	double	maxArea;
+	double	minVar;
+	double	pHigh;
+	double	pLow;
+	double	theta;
+	int		nbins;
+	int		gradSESize;
+	int		areaSESize;
+	int		postSESize;
+};
+
+//********** struct ParameterGrid ************************************************
+
+// values to try for each parameter; the grid is their cartesian product
+struct ParameterGrid
+{
+	vector<double>	minArea;
+	vector<double>	maxArea;
+	vector<double>	minVar;
+	vector<double>	pHigh;
+	vector<double>	pLow;
+	vector<double>	theta;
+	vector<int>		nbins;
+	vector<int>		gradSESize;
+	vector<int>		areaSESize;
+	vector<int>		postSESize;
+
+	// a grid of the single point p, to widen parameter by parameter
+	explicit ParameterGrid(const FGParameters& p);
+
+	// every combination, the last parameter varying fastest
+	vector<FGParameters> points() const;
+};
+
+//********** struct SweepStats ***************************************************
+
+// work of the last run, against what running each point on its own would do
+struct SweepStats
+{
+	size_t	points;
+	size_t	images;
+	size_t	localizations;		// coarse localizations run
+	size_t	regions;			// local regions summed over the localizations
+	size_t	thresholdMasks;		// thresholded and filtered region masks computed
+	size_t	unsharedMasks;		// the same without sharing, two per region and point
+	double	seconds;
+};
+
+//********** class ParameterSweep ************************************************
+
+class ParameterSweep
+{
+public:
+	// called as each mask is done, possibly from several threads at once
+	//     point - index of the grid point
+	//     image - index of the image
+	//     fgImg - binary object mask
+	typedef std::function<void(size_t point, size_t image, const Mat& fgImg)> ResultCallback;
+
+	// settings - engine settings other than the parameters, e.g. the pyramid
+	//            level and fast morphology
+	// threads  - pool size, 0 for one per hardware thread
+	explicit ParameterSweep(const FGExtraction& settings, int threads = 0);
+	~ParameterSweep();
+
+	// segments every image for every point, one image after the other
+	void run(const vector<Mat>& inImgs, const vector<FGParameters>& points, const ResultCallback& onResult);
+
+	// same, keeping the masks as fgImgs[point][image]
+	void run(const vector<Mat>& inImgs, const vector<FGParameters>& points, vector<vector<Mat>>& fgImgs);
+
+	const SweepStats& stats() const { return _stats; }
+
+private:
+	// a local region and its masks by threshold
+	struct Region
+	{
+		Rect						window;
+		Mat							mask;			// ellipse of the region, window-sized
+		BitMask						maskBits;		// the same as a bit mask
+		int							thresh;			// Otsu threshold in the ellipse
+		int							u;				// mean of the lower Otsu class
+		map<int, vector<int>>		levelHists;		// gray level histogram of each filtered mask
+		bool						failed;			// thresholding threw
+	};
+
+	// the points sharing one coarse localization
+	struct Group
+	{
+		vector<size_t>				points;
+		vector<Region>				regions;
+		bool						failed;			// localization or a region threw
+	};
+
+	FGExtraction*			_settings;		// reads the settings and runs the stateless stages
+	int						_threads;
+	vector<FGExtraction*>	_engines;
+	vector<FGExtraction*>	_idleEngines;
+	std::mutex				_mutex;			// guards _engines and _idleEngines
+	SweepStats				_stats;
+
+	FGExtraction* acquireEngine(const FGParameters& p);
+	void releaseEngine(FGExtraction* engine);
+
+	void localizeGroup(const Mat& inImg, const vector<FGParameters>& points, Group& group);
+	void thresholdRegion(const Mat& inImg, const vector<FGParameters>& points, const Group& group, Region& region);
+	void segmentPoint(const Mat& inImg, const FGParameters& p, const Group& group, Mat& fgImg);
+
+	static int shiftedThreshold(const Region& region, double p);
+
+	ParameterSweep(const ParameterSweep&);
+	ParameterSweep& operator=(const ParameterSweep&);
+};
+
+#endif
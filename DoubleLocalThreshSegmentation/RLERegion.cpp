@@ -0,0 +1,153 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  RLERegion.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <algorithm>
+#include <climits>
+
+#include "RLERegion.h"
+
+//********** class RLERegion *****************************************************
+
+// Builds the runs of a mask
+//     mask   - CV_8U mask, non-zero pixels belong to the region
+//     offset - position of the top-left mask pixel in region coordinates
+//
+void RLERegion::fromMask(const Mat& mask, Point offset)
+{
+	CV_Assert(mask.type() == CV_8U);
+	_runs.clear();
+	for(int y = 0; y < mask.rows; ++y){
+		const uchar* row = mask.ptr<uchar>(y);
+		for(int x = 0; x < mask.cols; ){
+			if(!row[x]){
+				++x;
+				continue;
+			}
+			int x0 = x;
+			while(x < mask.cols && row[x])
+				++x;
+			RLERun run = { y + offset.y, x0 + offset.x, x + offset.x };
+			_runs.push_back(run);
+		}
+	}
+}
+
+// Builds the runs of a filled contour
+//     contour      - closed contour, e.g. from findContours
+//     scratch      - buffer for the bounding box window
+//     allocCounter - incremented when the scratch buffer grows
+//
+void RLERegion::fromContour(const vector<Point>& contour, ScratchMat& scratch, int* allocCounter)
+{
+	_runs.clear();
+	if(contour.empty())
+		return;
+
+	// a filled polygon never leaves the bounding box of its vertices
+	Rect box = cv::boundingRect(contour);
+	Mat window = scratch.get(box.size(), CV_8U, allocCounter);
+	window.setTo(0);
+
+	// fillPoly fills the polygon as drawContours does, without copying the points
+	const Point* points = &contour[0];
+	int count = (int)contour.size();
+	fillPoly(window, &points, &count, 1, Scalar(255), 8, 0, -box.tl());
+	fromMask(window, box.tl());
+}
+
+int64 RLERegion::area() const
+{
+	int64 area = 0;
+	for(size_t i = 0; i < _runs.size(); ++i)
+		area += _runs[i].x1 - _runs[i].x0;
+	return area;
+}
+
+Rect RLERegion::boundingRect() const
+{
+	if(_runs.empty())
+		return Rect();
+	int left = INT_MAX, right = INT_MIN;
+	for(size_t i = 0; i < _runs.size(); ++i){
+		left = std::min(left, _runs[i].x0);
+		right = std::max(right, _runs[i].x1);
+	}
+	int top = _runs.front().y;
+	int bottom = _runs.back().y + 1;
+	return Rect(left, top, right - left, bottom - top);
+}
+
+// adds a run after the last one, merging it with the last run if they touch
+void RLERegion::append(int y, int x0, int x1)
+{
+	if(x0 >= x1)
+		return;
+	if(!_runs.empty()){
+		RLERun& last = _runs.back();
+		if(last.y == y && x0 <= last.x1){
+			last.x1 = std::max(last.x1, x1);
+			return;
+		}
+	}
+	RLERun run = { y, x0, x1 };
+	_runs.push_back(run);
+}
+
+// Intersection, walking both sorted run lists once
+RLERegion RLERegion::intersect(const RLERegion& other) const
+{
+	RLERegion result;
+	const vector<RLERun>& a = _runs;
+	const vector<RLERun>& b = other._runs;
+	size_t i = 0, j = 0;
+	while(i < a.size() && j < b.size()){
+		if(a[i].y != b[j].y){
+			if(a[i].y < b[j].y) ++i; else ++j;
+			continue;
+		}
+		result.append(a[i].y, std::max(a[i].x0, b[j].x0), std::min(a[i].x1, b[j].x1));
+
+		// drop the run that ends first, the other may overlap the next one
+		if(a[i].x1 < b[j].x1) ++i; else ++j;
+	}
+	return result;
+}
+
+// Union, merging both sorted run lists in order
+RLERegion RLERegion::unite(const RLERegion& other) const
+{
+	RLERegion result;
+	const vector<RLERun>& a = _runs;
+	const vector<RLERun>& b = other._runs;
+	size_t i = 0, j = 0;
+	while(i < a.size() || j < b.size()){
+		bool takeA = j == b.size() ||
+					 (i < a.size() && (a[i].y < b[j].y || (a[i].y == b[j].y && a[i].x0 <= b[j].x0)));
+		const RLERun& run = takeA ? a[i++] : b[j++];
+		result.append(run.y, run.x0, run.x1);
+	}
+	return result;
+}
+
+// Fills the region into an image
+//     img    - CV_8U image
+//     value  - value of the region pixels
+//     origin - region coordinates of the top-left pixel of img
+//
+void RLERegion::fill(Mat& img, uchar value, Point origin) const
+{
+	CV_Assert(img.type() == CV_8U);
+	for(size_t i = 0; i < _runs.size(); ++i){
+		const RLERun& run = _runs[i];
+		int y = run.y - origin.y;
+		if(y < 0 || y >= img.rows)
+			continue;
+		int x0 = std::max(run.x0 - origin.x, 0);
+		int x1 = std::min(run.x1 - origin.x, img.cols);
+		if(x0 < x1)
+			std::fill(img.ptr<uchar>(y) + x0, img.ptr<uchar>(y) + x1, value);
+	}
+}
@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  RLERegion.h
+//  Date:   Oct/16/2026
+//
+//  Image region stored as run lengths: one [x0, x1) span per row segment,
+//  sorted by row, then column. Area, set operations, filling and pixel
+//  iteration cost O(number of runs), so per-object work scales with the
+//  object, not with the frame that holds it.
+//
+
+#ifndef _RLEREGION_H_
+#define _RLEREGION_H_
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "util.h"
+
+using namespace std;
+using namespace cv;
+
+//********** class RLERegion *****************************************************
+
+// pixels x0 .. x1-1 of row y
+struct RLERun
+{
+	int y;
+	int x0;
+	int x1;
+};
+
+class RLERegion
+{
+public:
+	RLERegion() {}
+
+	// runs of the non-zero pixels of a CV_8U mask whose top-left pixel is at offset
+	void fromMask(const Mat& mask, Point offset = Point());
+
+	// pixels of a contour filled by drawContours, rasterized in a window the
+	// size of its bounding box
+	//     scratch      - buffer for the window, reused from call to call
+	//     allocCounter - incremented when the scratch buffer grows
+	void fromContour(const vector<Point>& contour, ScratchMat& scratch, int* allocCounter = 0);
+
+	// takes runs as runs() returns them, sorted and not touching, e.g. read back from a file
+	void assign(const vector<RLERun>& runs) { _runs = runs; }
+
+	void clear() { _runs.clear(); }
+	bool empty() const { return _runs.empty(); }
+	const vector<RLERun>& runs() const { return _runs; }
+
+	// number of pixels
+	int64 area() const;
+	Rect boundingRect() const;
+
+	// pixels in both regions, or in either one
+	RLERegion intersect(const RLERegion& other) const;
+	RLERegion unite(const RLERegion& other) const;
+
+	// sets the pixels of the region in img, shifted by -origin, clipped to img
+	void fill(Mat& img, uchar value, Point origin = Point()) const;
+
+	// calls f(y, x0, x1) for every run
+	template<class F> void forEachRun(F f) const
+	{
+		for(size_t i = 0; i < _runs.size(); ++i)
+			f(_runs[i].y, _runs[i].x0, _runs[i].x1);
+	}
+
+	// calls f(x, y) for every pixel, row by row
+	template<class F> void forEachPixel(F f) const
+	{
+		for(size_t i = 0; i < _runs.size(); ++i)
+			for(int x = _runs[i].x0; x < _runs[i].x1; ++x)
+				f(x, _runs[i].y);
+	}
+
+private:
+	vector<RLERun> _runs;
+
+	void append(int y, int x0, int x1);
+};
+
+#endif
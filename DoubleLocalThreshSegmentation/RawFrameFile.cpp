@@ -0,0 +1,176 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  RawFrameFile.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <cstring>
+#include <cstdint>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "RawFrameFile.h"
+
+#ifdef _WIN32
+#define fseek64 _fseeki64
+#define ftell64 _ftelli64
+#else
+#define fseek64 fseeko
+#define ftell64 ftello
+#endif
+
+//********** file layout *********************************************************
+
+static const char rawMagic[8] = { 'D', 'L', 'T', 'S', 'R', 'A', 'W', '1' };
+static const uint32_t rawVersion = 1;
+static const size_t rawHeaderBytes = 32;
+
+static void makeHeader(uchar* header, Size frameSize)
+{
+	memset(header, 0, rawHeaderBytes);
+	memcpy(header, rawMagic, 8);
+	memcpy(header + 8, &rawVersion, 4);
+	int32_t dims[2] = { frameSize.width, frameSize.height };
+	memcpy(header + 16, dims, 8);
+}
+
+// size of the frames of a container header, an empty size if it is none
+static Size parseHeader(const uchar* header)
+{
+	uint32_t version;
+	int32_t dims[2];
+	memcpy(&version, header + 8, 4);
+	memcpy(dims, header + 16, 8);
+	if(memcmp(header, rawMagic, 8) != 0 || version != rawVersion || dims[0] <= 0 || dims[1] <= 0)
+		return Size();
+	return Size(dims[0], dims[1]);
+}
+
+//********** class RawFrameWriter ************************************************
+
+RawFrameWriter::RawFrameWriter()
+	: _file(NULL)
+{
+
+}
+
+RawFrameWriter::~RawFrameWriter()
+{
+	close();
+}
+
+// Opens a container for appending
+//     filename  - container file
+//     frameSize - size of the frames
+//
+//     returns : false if the file cannot be created, is not a container, or
+//               holds frames of another size
+//
+bool RawFrameWriter::open(const string& filename, Size frameSize)
+{
+	close();
+	if(frameSize.width <= 0 || frameSize.height <= 0)
+		return false;
+	_file = fopen(filename.c_str(), "r+b");
+	if(!_file)
+		_file = fopen(filename.c_str(), "w+b");
+	if(!_file)
+		return false;
+
+	uchar header[rawHeaderBytes];
+	fseek64(_file, 0, SEEK_END);
+	int64 size = (int64)ftell64(_file);
+	if(size == 0){
+		makeHeader(header, frameSize);
+		if(fwrite(header, 1, rawHeaderBytes, _file) != rawHeaderBytes){
+			close();
+			return false;
+		}
+	}
+	else{
+		fseek64(_file, 0, SEEK_SET);
+		if(fread(header, 1, rawHeaderBytes, _file) != rawHeaderBytes || parseHeader(header) != frameSize){
+			close();
+			return false;
+		}
+
+		// drop a frame that was cut off, so the next one starts where it belongs
+		int64 frameBytes = (int64)frameSize.area();
+		int64 end = (int64)rawHeaderBytes + (size - (int64)rawHeaderBytes) / frameBytes * frameBytes;
+		fseek64(_file, end, SEEK_SET);
+	}
+	_frameSize = frameSize;
+	return true;
+}
+
+void RawFrameWriter::close()
+{
+	if(_file)
+		fclose(_file);
+	_file = NULL;
+}
+
+// Appends a frame
+//     frame - grayscale or BGR frame of the container's size
+//
+//     returns : false on a write error
+//
+bool RawFrameWriter::write(const Mat& frame)
+{
+	if(!_file || frame.size() != _frameSize || frame.depth() != CV_8U)
+		return false;
+
+	Mat gray = frame;
+	if(frame.channels() != 1){
+		cvtColor(frame, _grayImg, COLOR_BGR2GRAY);
+		gray = _grayImg;
+	}
+	for(int y = 0; y < gray.rows; ++y){
+		if(fwrite(gray.ptr<uchar>(y), 1, gray.cols, _file) != (size_t)gray.cols)
+			return false;
+	}
+	return true;
+}
+
+//********** class RawFrameReader ************************************************
+
+RawFrameReader::RawFrameReader()
+	: _frameCount(0)
+{
+
+}
+
+// Maps a container
+//     filename - container file
+//
+//     returns : false if the file cannot be mapped or is not a container
+//
+bool RawFrameReader::open(const string& filename)
+{
+	close();
+	if(!_file.open(filename) || _file.size() < rawHeaderBytes){
+		close();
+		return false;
+	}
+	_frameSize = parseHeader(_file.data());
+	if(_frameSize.area() == 0){
+		close();
+		return false;
+	}
+	_frameCount = (_file.size() - rawHeaderBytes) / (size_t)_frameSize.area();
+	return true;
+}
+
+void RawFrameReader::close()
+{
+	_file.close();
+	_frameSize = Size();
+	_frameCount = 0;
+}
+
+Mat RawFrameReader::frame(size_t i) const
+{
+	CV_Assert(i < _frameCount);
+	const uchar* data = _file.data() + rawHeaderBytes + i * (size_t)_frameSize.area();
+	return Mat(_frameSize, CV_8U, const_cast<uchar*>(data));
+}
@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  RawFrameFile.h
+//  Date:   Oct/16/2026
+//
+//  Container of uncompressed 8-bit grayscale frames of one size, stored
+//  back to back after a 32-byte header, so frame i starts at a computed
+//  offset. The reader maps the file and hands out Mat headers pointing
+//  into the mapping: no decode, no color conversion and no copy stand
+//  between the disk cache and FGExtraction.
+//
+//  Layout: "DLTSRAW1", u32 version, u32 reserved, i32 width, i32 height,
+//          8 reserved bytes, then width x height bytes per frame
+//
+
+#ifndef _RAWFRAMEFILE_H_
+#define _RAWFRAMEFILE_H_
+
+#include <cstdio>
+#include <string>
+
+#include <opencv2/core/core.hpp>
+
+#include "MappedFile.h"
+
+using namespace std;
+using namespace cv;
+
+//********** class RawFrameWriter ************************************************
+
+// Appends grayscale frames to a container
+class RawFrameWriter
+{
+public:
+	RawFrameWriter();
+	~RawFrameWriter();
+
+	// opens a container for appending, creating it for frames of frameSize if
+	// it does not exist
+	//     returns : false if it cannot be created, is not a container, or
+	//               holds frames of another size
+	bool open(const string& filename, Size frameSize);
+	void close();
+	bool isOpen() const { return _file != NULL; }
+
+	// appends a frame of the container's size; color frames are converted
+	//     returns : false on a write error
+	bool write(const Mat& frame);
+
+private:
+	FILE*	_file;
+	Size	_frameSize;
+	Mat		_grayImg;
+
+	RawFrameWriter(const RawFrameWriter&);
+	RawFrameWriter& operator=(const RawFrameWriter&);
+};
+
+//********** class RawFrameReader ************************************************
+
+// Zero-copy access to the frames of a memory-mapped container
+class RawFrameReader
+{
+public:
+	RawFrameReader();
+
+	// maps a container; a partly written frame at the end is ignored
+	//     returns : false if it cannot be mapped or is not a container
+	bool open(const string& filename);
+	void close();
+
+	size_t frameCount() const { return _frameCount; }
+	Size frameSize() const { return _frameSize; }
+
+	// CV_8U header of frame i pointing into the mapping, valid until close();
+	// the mapping is read-only, so the frame must not be written to
+	Mat frame(size_t i) const;
+
+private:
+	MappedFile	_file;
+	Size		_frameSize;
+	size_t		_frameCount;
+};
+
+#endif
@@ -0,0 +1,285 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  SegmentationClient.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "SegmentationClient.h"
+
+// larger replies can only come from a broken stream
+static const uint64_t maxPayloadBytes = (uint64_t)1 << 31;
+
+//********** class SegmentationClient ********************************************
+
+SegmentationClient::SegmentationClient()
+	: _fd(-1), _serviceWorkers(0), _nextRequestId(1), _connected(false)
+{
+
+}
+
+SegmentationClient::~SegmentationClient()
+{
+	close();
+}
+
+// Connects to the service and hands it a new ring
+//     socketPath   - socket the service listens on
+//     maxFrameSize - largest frame that will be submitted
+//     slots        - number of frames in flight at most
+//
+//     returns : false if the service cannot be reached or cannot map the ring
+//
+bool SegmentationClient::connect(const string& socketPath, Size maxFrameSize, int slots)
+{
+	close();
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if(socketPath.size() >= sizeof(addr.sun_path) || maxFrameSize.width <= 0 || maxFrameSize.height <= 0)
+		return false;
+	strcpy(addr.sun_path, socketPath.c_str());
+
+	// the ring name only has to be unique on the node while it exists
+	static std::atomic<int> ringCounter(0);
+	string ringName = format("/dlts-%d-%d", (int)getpid(), (int)ringCounter++);
+	if(!_ring.create(ringName, slots, (size_t)maxFrameSize.width * maxFrameSize.height))
+		return false;
+
+	ServiceHello hello;
+	memset(&hello, 0, sizeof(hello));
+	hello.magic = serviceMagic;
+	hello.version = serviceVersion;
+	strncpy(hello.ringName, ringName.c_str(), sizeof(hello.ringName) - 1);
+	ServiceHelloReply reply;
+
+	_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(_fd < 0 || ::connect(_fd, (const sockaddr*)&addr, sizeof(addr)) != 0 ||
+	   (disableSigPipe(_fd), !sendAll(_fd, &hello, sizeof(hello))) ||
+	   !recvAll(_fd, &reply, sizeof(reply)) || reply.status != STATUS_OK){
+		close();
+		return false;
+	}
+
+	// both processes have the ring mapped now, so its name can go
+	_ring.unlink();
+	_serviceWorkers = (int)reply.workers;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_freeSlots.clear();
+		for(int i = slots - 1; i >= 0; --i)
+			_freeSlots.push_back(i);
+		_connected = true;
+	}
+	_receiver = std::thread(&SegmentationClient::receiveLoop, this);
+	return true;
+}
+
+// Disconnects; results still in flight fail. Must not be called from a callback
+void SegmentationClient::close()
+{
+	if(_fd >= 0)
+		shutdown(_fd, SHUT_RDWR);
+	if(_receiver.joinable())
+		_receiver.join();
+	if(_fd >= 0)
+		::close(_fd);
+	_fd = -1;
+	_ring.close();
+	_serviceWorkers = 0;
+	std::lock_guard<std::mutex> lock(_mutex);
+	_connected = false;
+}
+
+bool SegmentationClient::isConnected() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _connected;
+}
+
+std::future<SegmentationResult> SegmentationClient::submit(const Mat& inImg, int flags)
+{
+	std::shared_ptr<std::promise<SegmentationResult>> promise = std::make_shared<std::promise<SegmentationResult>>();
+	std::future<SegmentationResult> future = promise->get_future();
+	submit(inImg, flags, [promise](const SegmentationResult& result) { promise->set_value(result); });
+	return future;
+}
+
+// Writes a frame to a free slot and submits it, blocking while no slot is free
+//     inImg    - CV_8U grayscale or CV_8UC3 color frame up to the size given to connect
+//     flags    - RESULT_MASK and/or RESULT_OBJECTS
+//     onResult - called once with the result, on failure too
+//
+void SegmentationClient::submit(const Mat& inImg, int flags, const ResultCallback& onResult)
+{
+	SegmentationResult failed;
+	failed.ok = false;
+	if(inImg.empty() || (inImg.type() != CV_8U && inImg.type() != CV_8UC3) || !_ring.fits(inImg.size())){
+		onResult(failed);
+		return;
+	}
+
+	int slot;
+	uint64_t requestId;
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while(_connected && _freeSlots.empty())
+			_slotFree.wait(lock);
+		if(!_connected){
+			lock.unlock();
+			onResult(failed);
+			return;
+		}
+		slot = _freeSlots.back();
+		_freeSlots.pop_back();
+		requestId = _nextRequestId++;
+	}
+
+	// the only copy of the pixels, straight into shared memory
+	Mat frame = _ring.frame(slot, inImg.size());
+	if(inImg.channels() == 1)
+		inImg.copyTo(frame);
+	else
+		cvtColor(inImg, frame, COLOR_BGR2GRAY);
+
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		if(!_connected){
+			lock.unlock();
+			onResult(failed);
+			return;
+		}
+		Pending& pending = _pending[requestId];
+		pending.slot = slot;
+		pending.size = inImg.size();
+		pending.flags = flags;
+		pending.onResult = onResult;
+	}
+
+	ServiceRequest request;
+	memset(&request, 0, sizeof(request));
+	request.type = MSG_SEGMENT;
+	request.slot = (uint32_t)slot;
+	request.requestId = requestId;
+	request.width = inImg.cols;
+	request.height = inImg.rows;
+	request.flags = (uint32_t)flags;
+	sendRequest(request);
+}
+
+// Asks the service for its counters and waits for them
+bool SegmentationClient::serviceStats(ServiceStats& stats)
+{
+	std::shared_ptr<std::promise<bool>> promise = std::make_shared<std::promise<bool>>();
+	std::future<bool> future = promise->get_future();
+	uint64_t requestId;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if(!_connected)
+			return false;
+		requestId = _nextRequestId++;
+		Pending& pending = _pending[requestId];
+		pending.slot = -1;
+		pending.flags = 0;
+		pending.onStats = [promise, &stats](const ServiceStats* received) {
+			if(received)
+				stats = *received;
+			promise->set_value(received != NULL);
+		};
+	}
+
+	ServiceRequest request;
+	memset(&request, 0, sizeof(request));
+	request.type = MSG_STATS;
+	request.requestId = requestId;
+	sendRequest(request);
+	return future.get();
+}
+
+// a failed send leaves the request to failPending, as the receiver sees the
+// broken socket too once it is shut down
+bool SegmentationClient::sendRequest(const ServiceRequest& request)
+{
+	std::lock_guard<std::mutex> lock(_sendMutex);
+	if(sendAll(_fd, &request, sizeof(request)))
+		return true;
+	shutdown(_fd, SHUT_RDWR);
+	return false;
+}
+
+// Completes requests as their replies arrive, until the socket closes
+void SegmentationClient::receiveLoop()
+{
+	ServiceReply reply;
+	vector<uchar> payload;
+	while(recvAll(_fd, &reply, sizeof(reply)) && reply.payloadBytes <= maxPayloadBytes){
+		payload.resize((size_t)reply.payloadBytes);
+		if(!payload.empty() && !recvAll(_fd, &payload[0], payload.size()))
+			break;
+
+		Pending pending;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			map<uint64_t, Pending>::iterator it = _pending.find(reply.requestId);
+			if(it == _pending.end())
+				continue;
+			pending = it->second;
+			_pending.erase(it);
+		}
+
+		if(pending.slot < 0){
+			ServiceStats stats;
+			bool ok = reply.status == STATUS_OK && payload.size() == sizeof(stats);
+			if(ok)
+				memcpy(&stats, &payload[0], sizeof(stats));
+			pending.onStats(ok ? &stats : NULL);
+			continue;
+		}
+
+		// the slot is free again once the mask is copied out of it
+		SegmentationResult result;
+		result.ok = reply.status == STATUS_OK;
+		if(result.ok && (pending.flags & RESULT_MASK))
+			_ring.mask(pending.slot, pending.size).copyTo(result.fgImg);
+		if(result.ok && (pending.flags & RESULT_OBJECTS))
+			result.ok = decodeObjects(payload.empty() ? NULL : &payload[0], payload.size(), reply.objectCount,
+									  result.objects);
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_freeSlots.push_back(pending.slot);
+		}
+		_slotFree.notify_one();
+		pending.onResult(result);
+	}
+	failPending();
+}
+
+// fails every request in flight and wakes submitters waiting for a slot
+void SegmentationClient::failPending()
+{
+	map<uint64_t, Pending> pending;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_connected = false;
+		pending.swap(_pending);
+	}
+	_slotFree.notify_all();
+
+	SegmentationResult failed;
+	failed.ok = false;
+	for(map<uint64_t, Pending>::iterator it = pending.begin(); it != pending.end(); ++it){
+		if(it->second.slot < 0)
+			it->second.onStats(NULL);
+		else
+			it->second.onResult(failed);
+	}
+}
@@ -0,0 +1,107 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  SegmentationClient.h
+//  Date:   Oct/16/2026
+//
+//  Client of the local segmentation service, see SegmentationServer.h.
+//  Frames are written to a shared memory ring the client creates and are
+//  segmented by the service's warm workers; results come back as futures
+//  or callbacks, in completion order, while further frames are submitted.
+//
+
+#ifndef _SEGMENTATIONCLIENT_H_
+#define _SEGMENTATIONCLIENT_H_
+
+#include <map>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "ObjectList.h"
+#include "SharedFrameRing.h"
+#include "SegmentationProtocol.h"
+
+using namespace std;
+using namespace cv;
+
+//********** struct SegmentationResult *******************************************
+
+struct SegmentationResult
+{
+	bool					ok;			// false if the service rejected the frame or went away
+	Mat						fgImg;		// binary object mask, if RESULT_MASK was asked for
+	vector<SegmentedObject>	objects;	// if RESULT_OBJECTS was asked for
+};
+
+//********** class SegmentationClient ********************************************
+
+class SegmentationClient
+{
+public:
+	// called on the client's receive thread; it must not block for long,
+	// as the results behind it wait
+	typedef std::function<void(const SegmentationResult& result)> ResultCallback;
+
+	SegmentationClient();
+	~SegmentationClient();
+
+	// connects to the service and creates the ring
+	//     socketPath   - socket the service listens on
+	//     maxFrameSize - largest frame that will be submitted
+	//     slots        - frames in flight at most; submit blocks when all are
+	//     returns      : false if the service cannot be reached or refuses the ring
+	bool connect(const string& socketPath, Size maxFrameSize, int slots = 4);
+
+	// fails what is in flight and disconnects
+	void close();
+	bool isConnected() const;
+
+	// number of workers of the service, known once connected
+	int serviceWorkers() const { return _serviceWorkers; }
+
+	// submits a frame, converted to grayscale in the ring if it is color
+	//     flags - RESULT_MASK and/or RESULT_OBJECTS
+	std::future<SegmentationResult> submit(const Mat& inImg, int flags = RESULT_MASK);
+	void submit(const Mat& inImg, int flags, const ResultCallback& onResult);
+
+	// counters of the service, blocking until they arrive
+	//     returns : false if the service is gone
+	bool serviceStats(ServiceStats& stats);
+
+private:
+	struct Pending
+	{
+		int					slot;		// -1 for a stats request
+		Size				size;
+		int					flags;
+		ResultCallback		onResult;
+		std::function<void(const ServiceStats*)>	onStats;
+	};
+
+	int							_fd;
+	SharedFrameRing				_ring;
+	int							_serviceWorkers;
+	std::thread					_receiver;
+
+	mutable std::mutex			_mutex;		// guards everything below
+	std::condition_variable		_slotFree;
+	vector<int>					_freeSlots;
+	map<uint64_t, Pending>		_pending;
+	uint64_t					_nextRequestId;
+	bool						_connected;
+	std::mutex					_sendMutex;	// one request at a time on the socket
+
+	bool sendRequest(const ServiceRequest& request);
+	void receiveLoop();
+	void failPending();
+
+	SegmentationClient(const SegmentationClient&);
+	SegmentationClient& operator=(const SegmentationClient&);
+};
+
+#endif
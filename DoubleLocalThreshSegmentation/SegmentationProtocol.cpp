@@ -0,0 +1,72 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  SegmentationProtocol.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <cerrno>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "SegmentationProtocol.h"
+
+// a peer that went away must not raise SIGPIPE in a long-lived process
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+//********** socket helpers **************************************************************************
+
+bool sendAll(int fd, const void* data, size_t size)
+{
+	const char* p = (const char*)data;
+	while(size > 0){
+		ssize_t n = send(fd, p, size, SEND_FLAGS);
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0)
+			return false;
+		p += n;
+		size -= (size_t)n;
+	}
+	return true;
+}
+
+// where MSG_NOSIGNAL is missing, the socket itself is told not to raise SIGPIPE
+void disableSigPipe(int fd)
+{
+#ifdef SO_NOSIGPIPE
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+	(void)fd;
+#endif
+}
+
+// send() then fails with EAGAIN instead of blocking on a full socket buffer
+void setSendTimeout(int fd, int milliseconds)
+{
+	timeval timeout;
+	timeout.tv_sec = milliseconds / 1000;
+	timeout.tv_usec = (milliseconds % 1000) * 1000;
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+bool recvAll(int fd, void* data, size_t size)
+{
+	char* p = (char*)data;
+	while(size > 0){
+		ssize_t n = recv(fd, p, size, 0);
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0)
+			return false;
+		p += n;
+		size -= (size_t)n;
+	}
+	return true;
+}
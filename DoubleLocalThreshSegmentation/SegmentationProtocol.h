@@ -0,0 +1,112 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  SegmentationProtocol.h
+//  Date:   Oct/16/2026
+//
+//  Messages between the segmentation service and its clients on a Unix
+//  domain stream socket. Pixels never pass through the socket: a client
+//  creates a SharedFrameRing, names it in its hello, then writes each frame
+//  to a free slot and submits the slot. The service segments the frame in
+//  place, writes the mask to the mask area of the slot and replies; the
+//  slot belongs to the service from the request until the reply. Object
+//  lists, which are small, follow the reply in the encoding of ObjectList.h.
+//
+//  All messages are fixed-size structs in host byte order, as both ends
+//  run on the same node:
+//      client  ServiceHello, then any number of ServiceRequest
+//      service ServiceHelloReply, then one ServiceReply per request, in
+//              completion order, each followed by payloadBytes of payload
+//
+
+#ifndef _SEGMENTATIONPROTOCOL_H_
+#define _SEGMENTATIONPROTOCOL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+//********** messages ************************************************************
+
+static const uint32_t serviceMagic = 0x53544C44;	// "DLTS"
+static const uint32_t serviceVersion = 1;
+
+enum ServiceMessage
+{
+	MSG_SEGMENT = 1,	// segment the frame in a slot
+	MSG_STATS = 2		// report the service counters
+};
+
+// what a segment request returns
+enum ServiceResultFlags
+{
+	RESULT_MASK = 1,	// the mask, in the mask area of the slot
+	RESULT_OBJECTS = 2	// the object list, as the payload of the reply
+};
+
+enum ServiceStatus
+{
+	STATUS_OK = 0,
+	STATUS_BAD_REQUEST = 1,		// unknown message, slot or frame size
+	STATUS_NO_RING = 2,			// the ring of the hello cannot be mapped
+	STATUS_FAILED = 3			// segmentation threw, e.g. on a damaged frame
+};
+
+struct ServiceHello
+{
+	uint32_t	magic;
+	uint32_t	version;
+	char		ringName[64];	// of the client's SharedFrameRing, NUL-terminated
+};
+
+struct ServiceHelloReply
+{
+	uint32_t	status;
+	uint32_t	workers;
+};
+
+struct ServiceRequest
+{
+	uint32_t	type;			// ServiceMessage
+	uint32_t	slot;
+	uint64_t	requestId;		// chosen by the client, echoed in the reply
+	int32_t		width;			// of the grayscale frame in the slot
+	int32_t		height;
+	uint32_t	flags;			// ServiceResultFlags
+	uint32_t	reserved;
+};
+
+struct ServiceReply
+{
+	uint32_t	type;			// of the request
+	uint32_t	status;			// ServiceStatus
+	uint64_t	requestId;
+	uint32_t	objectCount;	// objects in the payload
+	uint32_t	reserved;
+	uint64_t	payloadBytes;
+};
+
+// payload of the reply to MSG_STATS
+struct ServiceStats
+{
+	uint64_t	frames;			// frames segmented since the start
+	uint64_t	rejected;		// requests answered with an error
+	uint32_t	workers;
+	uint32_t	clients;		// connected now
+	uint32_t	queued;			// frames waiting for a worker
+	uint32_t	reserved;
+	double		busySeconds;	// segmentation time summed over the workers
+};
+
+//********** socket helpers **************************************************************************
+
+// send or receive exactly size bytes, retrying on interrupts and short transfers
+//     returns : false once the peer is gone or on an error
+bool sendAll(int fd, const void* data, size_t size);
+bool recvAll(int fd, void* data, size_t size);
+
+// keeps sendAll from raising SIGPIPE on a socket whose peer is gone
+void disableSigPipe(int fd);
+
+// makes sendAll fail once the peer has not read anything for milliseconds
+void setSendTimeout(int fd, int milliseconds);
+
+#endif
@@ -0,0 +1,312 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  SegmentationServer.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "SegmentationServer.h"
+
+//********** functions *******************************************************************************
+
+// a client that reads none of its replies for this long is disconnected
+static const int replyTimeoutMs = 5000;
+
+static int resolveWorkers(int workers)
+{
+	return workers > 0 ? workers : std::max((int)std::thread::hardware_concurrency(), 1);
+}
+
+//********** class SegmentationServer ********************************************
+
+SegmentationServer::Connection::~Connection()
+{
+	::close(fd);
+}
+
+SegmentationServer::SegmentationServer(const FGExtraction& settings, int workers, size_t queueCapacity)
+	: _queue(queueCapacity > 0 ? queueCapacity : 2 * (size_t)resolveWorkers(workers)),
+	  _listenFd(-1), _readers(0), _frames(0), _rejected(0), _busyTicks(0)
+{
+	// every worker keeps its engine and workspace warm across clients
+	workers = resolveWorkers(workers);
+	for(int i = 0; i < workers; ++i){
+		FGExtraction* engine = settings.clone();
+		engine->_ws = FGExtraction::Workspace();
+		engine->_temporalMode = false;
+		engine->resetTemporalState();
+		engine->clearFrameCache();
+		engine->_stats = NULL;
+		engine->_trace = NULL;
+		_engines.push_back(engine);
+	}
+	if(pipe(_wakeFds) != 0)
+		_wakeFds[0] = _wakeFds[1] = -1;
+}
+
+SegmentationServer::~SegmentationServer()
+{
+	if(_listenFd >= 0){
+		::close(_listenFd);
+		unlink(_socketPath.c_str());
+	}
+	if(_wakeFds[0] >= 0){
+		::close(_wakeFds[0]);
+		::close(_wakeFds[1]);
+	}
+	for(size_t i = 0; i < _engines.size(); ++i)
+		delete _engines[i];
+}
+
+// Binds and listens on a Unix domain socket
+//     socketPath - file system path of the socket
+//
+//     returns : false if the path is too long, a server already listens
+//               there, or the socket cannot be bound
+//
+bool SegmentationServer::open(const string& socketPath)
+{
+	sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if(_listenFd >= 0 || _wakeFds[0] < 0 || socketPath.size() >= sizeof(addr.sun_path))
+		return false;
+	strcpy(addr.sun_path, socketPath.c_str());
+
+	// a socket file nobody accepts on is left over from a server that died
+	int probeFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(probeFd < 0)
+		return false;
+	bool live = connect(probeFd, (const sockaddr*)&addr, sizeof(addr)) == 0;
+	::close(probeFd);
+	if(live)
+		return false;
+	unlink(socketPath.c_str());
+
+	_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(_listenFd < 0)
+		return false;
+	if(bind(_listenFd, (const sockaddr*)&addr, sizeof(addr)) != 0 || listen(_listenFd, SOMAXCONN) != 0){
+		::close(_listenFd);
+		_listenFd = -1;
+		return false;
+	}
+	_socketPath = socketPath;
+	return true;
+}
+
+void SegmentationServer::run()
+{
+	if(_listenFd < 0)
+		return;
+	for(size_t i = 0; i < _engines.size(); ++i)
+		_workers.push_back(std::thread(&SegmentationServer::workerLoop, this, _engines[i]));
+
+	// accept until stop() writes to the wake pipe
+	for(;;){
+		pollfd fds[2];
+		fds[0].fd = _listenFd;
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
+		fds[1].fd = _wakeFds[0];
+		fds[1].events = POLLIN;
+		fds[1].revents = 0;
+		if(poll(fds, 2, -1) < 0){
+			if(errno == EINTR)
+				continue;
+			break;
+		}
+		if(fds[1].revents)
+			break;
+		if(!(fds[0].revents & POLLIN))
+			continue;
+		int fd = accept(_listenFd, NULL, NULL);
+		if(fd < 0)
+			continue;
+		disableSigPipe(fd);
+		setSendTimeout(fd, replyTimeoutMs);
+
+		std::shared_ptr<Connection> connection = std::make_shared<Connection>(fd);
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_connections.erase(std::remove_if(_connections.begin(), _connections.end(),
+											  [](const std::weak_ptr<Connection>& c) { return c.expired(); }),
+							   _connections.end());
+			_connections.push_back(connection);
+			++_readers;
+		}
+		std::thread(&SegmentationServer::serveConnection, this, connection).detach();
+	}
+
+	// stop reading requests, let the workers finish what is queued, then stop them
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		for(size_t i = 0; i < _connections.size(); ++i){
+			std::shared_ptr<Connection> connection = _connections[i].lock();
+			if(connection)
+				shutdown(connection->fd, SHUT_RD);
+		}
+		while(_readers > 0)
+			_readersDone.wait(lock);
+		_connections.clear();
+	}
+	_queue.close();
+	for(size_t i = 0; i < _workers.size(); ++i)
+		_workers[i].join();
+	_workers.clear();
+}
+
+void SegmentationServer::stop()
+{
+	// write() is async-signal-safe, unlike anything that locks
+	char wake = 0;
+	ssize_t n = write(_wakeFds[1], &wake, 1);
+	(void)n;
+}
+
+ServiceStats SegmentationServer::stats() const
+{
+	ServiceStats stats;
+	memset(&stats, 0, sizeof(stats));
+	stats.frames = _frames;
+	stats.rejected = _rejected;
+	stats.workers = (uint32_t)_engines.size();
+	stats.queued = (uint32_t)_queue.size();
+	stats.busySeconds = _busyTicks / getTickFrequency();
+	std::lock_guard<std::mutex> lock(_mutex);
+	stats.clients = (uint32_t)_readers;
+	return stats;
+}
+
+// Reads the requests of one client until it disconnects or the server stops
+void SegmentationServer::serveConnection(std::shared_ptr<Connection> connection)
+{
+	if(handshake(*connection)){
+		const SharedFrameRing& ring = connection->ring;
+		ServiceRequest request;
+		while(recvAll(connection->fd, &request, sizeof(request))){
+			if(request.type == MSG_STATS){
+				ServiceStats current = stats();
+				reply(*connection, request, STATUS_OK, 0, &current, sizeof(current));
+			}
+			else if(request.type == MSG_SEGMENT && request.slot < (uint32_t)ring.slotCount() &&
+					ring.fits(Size(request.width, request.height))){
+				// blocks while the queue is full, which holds the client back
+				Job job;
+				job.connection = connection;
+				job.request = request;
+				if(!_queue.push(job))
+					break;
+			}
+			else{
+				++_rejected;
+				reply(*connection, request, STATUS_BAD_REQUEST);
+			}
+		}
+	}
+
+	// queued jobs keep the connection, and so its socket and ring, until they reply
+	std::lock_guard<std::mutex> lock(_mutex);
+	--_readers;
+	_readersDone.notify_all();
+}
+
+// Reads the hello of a client and maps its ring
+//     returns : false if the client is not speaking the protocol or has no ring
+//
+bool SegmentationServer::handshake(Connection& connection)
+{
+	ServiceHello hello;
+	if(!recvAll(connection.fd, &hello, sizeof(hello)) || hello.magic != serviceMagic || hello.version != serviceVersion)
+		return false;
+	hello.ringName[sizeof(hello.ringName) - 1] = '\0';
+
+	ServiceHelloReply helloReply;
+	helloReply.status = connection.ring.open(hello.ringName) ? STATUS_OK : STATUS_NO_RING;
+	helloReply.workers = (uint32_t)_engines.size();
+	return sendAll(connection.fd, &helloReply, sizeof(helloReply)) && helloReply.status == STATUS_OK;
+}
+
+// Segments queued frames in place until the queue is closed and drained
+void SegmentationServer::workerLoop(FGExtraction* engine)
+{
+	Job job;
+	vector<SegmentedObject> objects;
+	vector<uchar> payload;
+	while(_queue.pop(job)){
+		const ServiceRequest& request = job.request;
+		Connection& connection = *job.connection;
+		Size size(request.width, request.height);
+		int64 start = getTickCount();
+
+		// both images are headers into the client's ring
+		Mat inImg = connection.ring.frame(request.slot, size);
+		Mat fgImg = connection.ring.mask(request.slot, size);
+		objects.clear();
+		payload.clear();
+		bool failed = false;
+		try{
+			if(request.flags & RESULT_OBJECTS){
+				if(request.flags & RESULT_MASK)
+					engine->extractObjects(inImg, objects, fgImg);
+				else
+					engine->extractObjects(inImg, objects);
+				encodeObjects(objects, payload);
+			}
+			else{
+				engine->extractForeground(inImg, fgImg);
+			}
+		}
+		catch(const std::exception&){
+			// cv::Exception included; the worker and the client's other frames go on
+			failed = true;
+		}
+		_busyTicks += getTickCount() - start;
+
+		if(failed){
+			++_rejected;
+			reply(connection, request, STATUS_FAILED);
+		}
+		else{
+			++_frames;
+			reply(connection, request, STATUS_OK, (uint32_t)objects.size(), payload.empty() ? NULL : &payload[0],
+				  payload.size());
+		}
+		job = Job();
+	}
+}
+
+// Sends the reply to a request, with its payload. A client that stopped
+// reading would block the worker once the socket buffer is full, so a send
+// that times out shuts the connection down: the reply may be cut short and
+// the stream is of no use anymore, the reader of the connection sees the end
+// of the requests, and later replies to it fail at once
+//     returns : false if the client is gone or not reading
+//
+bool SegmentationServer::reply(Connection& connection, const ServiceRequest& request, uint32_t status,
+							   uint32_t objectCount, const void* payload, size_t payloadBytes)
+{
+	ServiceReply serviceReply;
+	memset(&serviceReply, 0, sizeof(serviceReply));
+	serviceReply.type = request.type;
+	serviceReply.status = status;
+	serviceReply.requestId = request.requestId;
+	serviceReply.objectCount = objectCount;
+	serviceReply.payloadBytes = payloadBytes;
+
+	std::lock_guard<std::mutex> lock(connection.sendMutex);
+	bool sent = sendAll(connection.fd, &serviceReply, sizeof(serviceReply)) &&
+				(payloadBytes == 0 || sendAll(connection.fd, payload, payloadBytes));
+	if(!sent)
+		shutdown(connection.fd, SHUT_RDWR);
+	return sent;
+}
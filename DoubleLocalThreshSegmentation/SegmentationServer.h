@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  SegmentationServer.h
+//  Date:   Oct/16/2026
+//
+//  Long-lived local segmentation service. Clients connect on a Unix domain
+//  socket and pass frames through shared memory, see SegmentationProtocol.h;
+//  the frames of all clients go to one pool of workers, each with a warm
+//  FGExtraction engine, and every reply is sent as soon as its frame is
+//  done. A full queue stops reading requests, which in turn blocks clients
+//  once their slots are all submitted. A client that stops reading its
+//  replies is disconnected after a few seconds instead of holding a worker.
+//
+
+#ifndef _SEGMENTATIONSERVER_H_
+#define _SEGMENTATIONSERVER_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include "FGExtraction.h"
+#include "BoundedQueue.h"
+#include "SharedFrameRing.h"
+#include "SegmentationProtocol.h"
+
+//********** class SegmentationServer ********************************************
+
+class SegmentationServer
+{
+public:
+	// settings      - engine every worker copies, with its parameters and modes;
+	//                 temporal mode does not apply, as frames come from many streams
+	// workers       - number of workers, 0 for one per hardware thread
+	// queueCapacity - frames waiting for a worker before requests are no longer
+	//                 read, 0 for twice the workers
+	SegmentationServer(const FGExtraction& settings, int workers = 0, size_t queueCapacity = 0);
+	~SegmentationServer();
+
+	// listens on a socket, replacing a stale socket file of the same path
+	//     returns : false if the socket cannot be bound
+	bool open(const string& socketPath);
+
+	// serves clients until stop() is called, then closes every connection
+	// and returns once the workers are done
+	void run();
+
+	// makes run() return; safe from other threads and from signal handlers
+	void stop();
+
+	ServiceStats stats() const;
+
+private:
+	struct Connection
+	{
+		Connection(int fd) : fd(fd) {}
+		~Connection();
+
+		int					fd;
+		SharedFrameRing		ring;
+		std::mutex			sendMutex;	// one reply at a time
+	};
+
+	struct Job
+	{
+		std::shared_ptr<Connection>	connection;
+		ServiceRequest				request;
+	};
+
+	vector<FGExtraction*>			_engines;
+	vector<std::thread>				_workers;
+	BoundedQueue<Job>				_queue;
+	string							_socketPath;
+	int								_listenFd;
+	int								_wakeFds[2];	// stop() writes to [1]
+
+	// connections, each served by a thread of its own until it closes
+	mutable std::mutex				_mutex;
+	std::condition_variable			_readersDone;
+	vector<std::weak_ptr<Connection>>	_connections;
+	int								_readers;
+
+	std::atomic<uint64_t>			_frames;
+	std::atomic<uint64_t>			_rejected;
+	std::atomic<int64>				_busyTicks;
+
+	void serveConnection(std::shared_ptr<Connection> connection);
+	bool handshake(Connection& connection);
+	void workerLoop(FGExtraction* engine);
+	bool reply(Connection& connection, const ServiceRequest& request, uint32_t status,
+			   uint32_t objectCount = 0, const void* payload = NULL, size_t payloadBytes = 0);
+
+	SegmentationServer(const SegmentationServer&);
+	SegmentationServer& operator=(const SegmentationServer&);
+};
+
+#endif
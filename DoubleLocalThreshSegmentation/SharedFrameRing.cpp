@@ -0,0 +1,152 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  SharedFrameRing.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <cstring>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SharedFrameRing.h"
+
+//********** block layout ********************************************************
+
+static const char ringMagic[8] = { 'D', 'L', 'T', 'S', 'S', 'H', 'M', '1' };
+static const uint32_t ringVersion = 1;
+static const size_t ringHeaderBytes = 64;
+
+//********** class SharedFrameRing ***********************************************
+
+SharedFrameRing::SharedFrameRing()
+	: _data(NULL), _size(0), _slots(0), _frameBytes(0), _owner(false)
+{
+
+}
+
+SharedFrameRing::~SharedFrameRing()
+{
+	close();
+}
+
+// Creates a block and maps it
+//     name       - shared memory name
+//     slots      - number of slots
+//     frameBytes - largest frame, in pixels
+//
+//     returns : false if the name exists or the block cannot be created
+//
+bool SharedFrameRing::create(const string& name, int slots, size_t frameBytes)
+{
+	close();
+	if(slots <= 0 || frameBytes == 0)
+		return false;
+	frameBytes = (frameBytes + 63) / 64 * 64;
+	size_t size = ringHeaderBytes + 2 * frameBytes * slots;
+
+	// only this process and those it tells the name may map the block
+	int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+	if(fd < 0)
+		return false;
+	void* data = MAP_FAILED;
+	if(ftruncate(fd, (off_t)size) == 0)
+		data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(data == MAP_FAILED){
+		shm_unlink(name.c_str());
+		return false;
+	}
+
+	_data = (unsigned char*)data;
+	_size = size;
+	_name = name;
+	_slots = slots;
+	_frameBytes = frameBytes;
+	_owner = true;
+
+	uint32_t slotCount = (uint32_t)slots;
+	uint64 frameBytes64 = frameBytes;
+	memcpy(_data, ringMagic, 8);
+	memcpy(_data + 8, &ringVersion, 4);
+	memcpy(_data + 12, &slotCount, 4);
+	memcpy(_data + 16, &frameBytes64, 8);
+	return true;
+}
+
+// Maps a block created by another process
+//     name - shared memory name
+//
+//     returns : false if it does not exist or its header does not match its size
+//
+bool SharedFrameRing::open(const string& name)
+{
+	close();
+	int fd = shm_open(name.c_str(), O_RDWR, 0);
+	if(fd < 0)
+		return false;
+	struct stat st;
+	void* data = MAP_FAILED;
+	if(fstat(fd, &st) == 0 && (size_t)st.st_size >= ringHeaderBytes)
+		data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(data == MAP_FAILED)
+		return false;
+	_data = (unsigned char*)data;
+	_size = (size_t)st.st_size;
+	_name = name;
+
+	// the slots must lie within the block, whatever the header claims
+	uint32_t version, slots;
+	uint64 frameBytes;
+	memcpy(&version, _data + 8, 4);
+	memcpy(&slots, _data + 12, 4);
+	memcpy(&frameBytes, _data + 16, 8);
+	if(memcmp(_data, ringMagic, 8) != 0 || version != ringVersion || slots == 0 || frameBytes == 0 ||
+	   frameBytes % 64 != 0 || (_size - ringHeaderBytes) / 2 / slots < frameBytes){
+		close();
+		return false;
+	}
+	_slots = (int)slots;
+	_frameBytes = (size_t)frameBytes;
+	return true;
+}
+
+void SharedFrameRing::unlink()
+{
+	if(_owner)
+		shm_unlink(_name.c_str());
+	_owner = false;
+}
+
+void SharedFrameRing::close()
+{
+	unlink();
+	if(_data)
+		munmap(_data, _size);
+	_data = NULL;
+	_size = 0;
+	_name.clear();
+	_slots = 0;
+	_frameBytes = 0;
+}
+
+bool SharedFrameRing::fits(Size size) const
+{
+	return size.width > 0 && size.height > 0 && (size_t)size.width <= _frameBytes / size.height;
+}
+
+Mat SharedFrameRing::frame(int slot, Size size) const
+{
+	CV_Assert(slot >= 0 && slot < _slots && fits(size));
+	return Mat(size, CV_8U, _data + ringHeaderBytes + 2 * _frameBytes * slot);
+}
+
+Mat SharedFrameRing::mask(int slot, Size size) const
+{
+	CV_Assert(slot >= 0 && slot < _slots && fits(size));
+	return Mat(size, CV_8U, _data + ringHeaderBytes + 2 * _frameBytes * slot + _frameBytes);
+}
@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  SharedFrameRing.h
+//  Date:   Oct/16/2026
+//
+//  POSIX shared memory block of frame slots, through which the processes
+//  of one node hand frames and masks to each other without copying them
+//  through a socket. Every slot holds an input frame and a mask of up to
+//  frameBytes pixels each; which process may touch a slot is decided by
+//  the messages about it, see SegmentationProtocol.h.
+//
+//  Layout: "DLTSSHM1", u32 version, u32 slots, u64 frameBytes, padding to
+//  64 bytes, then per slot the frame area and the mask area, frameBytes
+//  each (a multiple of 64).
+//
+
+#ifndef _SHAREDFRAMERING_H_
+#define _SHAREDFRAMERING_H_
+
+#include <string>
+
+#include <opencv2/core/core.hpp>
+
+using namespace std;
+using namespace cv;
+
+//********** class SharedFrameRing ***********************************************
+
+class SharedFrameRing
+{
+public:
+	SharedFrameRing();
+	~SharedFrameRing();
+
+	// creates and maps a new block
+	//     name       - shared memory name, "/" followed by up to 30 characters
+	//     slots      - number of slots
+	//     frameBytes - largest frame, in pixels of CV_8U
+	//     returns    : false if the name exists or the block cannot be mapped
+	bool create(const string& name, int slots, size_t frameBytes);
+
+	// maps a block another process created
+	//     returns : false if it does not exist or is not a frame ring
+	bool open(const string& name);
+
+	// removes the name; the block lives on until every process unmaps it
+	void unlink();
+	void close();
+
+	bool isOpen() const { return _data != NULL; }
+	const string& name() const { return _name; }
+	int slotCount() const { return _slots; }
+	size_t frameBytes() const { return _frameBytes; }
+
+	// whether a frame of this size fits a slot
+	bool fits(Size size) const;
+
+	// CV_8U headers into the frame and mask areas of a slot, no data is copied
+	Mat frame(int slot, Size size) const;
+	Mat mask(int slot, Size size) const;
+
+private:
+	unsigned char*	_data;
+	size_t			_size;
+	string			_name;
+	int				_slots;
+	size_t			_frameBytes;
+	bool			_owner;		// created the name and has not unlinked it
+
+	SharedFrameRing(const SharedFrameRing&);
+	SharedFrameRing& operator=(const SharedFrameRing&);
+};
+
+#endif
@@ -0,0 +1,115 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  SyntheticScene.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <cmath>
+
+#include "SyntheticScene.h"
+
+//********** helper functions ************************************************************************
+
+// strobe light from above: bright at the top center, falling off downwards and sideways
+static void renderBackground(RNG& rng, Mat& bgImg)
+{
+	Size size = bgImg.size();
+	double base = rng.uniform(25.0, 45.0);
+	double gain = rng.uniform(40.0, 70.0);
+	for(int y = 0; y < size.height; ++y){
+		float* row = bgImg.ptr<float>(y);
+		double fy = double(y) / size.height;
+		for(int x = 0; x < size.width; ++x){
+			double fx = double(x) / size.width - 0.5;
+			row[x] = float(base + gain * (1 - fy) * (1 - fx*fx*2));
+		}
+	}
+
+	// low-frequency haze: upsampled coarse noise
+	Size coarse(std::max(size.width / 32, 2), std::max(size.height / 32, 2));
+	Mat haze(coarse, CV_32F);
+	rng.fill(haze, RNG::NORMAL, 0, 8);
+	Mat hazeImg;
+	resize(haze, hazeImg, size, 0, 0, INTER_CUBIC);
+	bgImg += hazeImg;
+}
+
+// a fish: elliptical body with a triangular tail fin
+static void renderObject(RNG& rng, const SceneParams& params, Mat& objImg, Mat& truthMask)
+{
+	Size size = objImg.size();
+	double length = params.objectSize * rng.uniform(0.6, 1.4);
+	double width = length * rng.uniform(0.22, 0.40);
+	double angle = rng.uniform(0.0, 180.0);
+	Point center(rng.uniform(0, size.width), rng.uniform(0, size.height));
+	double contrast = rng.uniform(40.0, 110.0);
+
+	Mat shapeMask = Mat::zeros(size, CV_8U);
+	Size axes(cvRound(length / 2), std::max(cvRound(width / 2), 1));
+	ellipse(shapeMask, center, axes, angle, 0, 360, Scalar(255), -1);
+
+	double rad = angle * CV_PI / 180;
+	Point2d dir(cos(rad), sin(rad));
+	Point2d normal(-dir.y, dir.x);
+	Point2d base = Point2d(center) - dir * (length * 0.45);
+	Point2d tip = Point2d(center) - dir * (length * 0.70);
+	Point tail[3] = {
+		Point(base),
+		Point(tip + normal * (width * 0.45)),
+		Point(tip - normal * (width * 0.45))
+	};
+	fillConvexPoly(shapeMask, tail, 3, Scalar(255));
+
+	// body brightness with some texture
+	Mat texture(size, CV_32F);
+	rng.fill(texture, RNG::NORMAL, 0, contrast * 0.12);
+	GaussianBlur(texture, texture, Size(0, 0), 2);
+	texture += Scalar(contrast);
+	texture.copyTo(objImg, shapeMask);
+
+	truthMask |= shapeMask;
+}
+
+//********** functions *******************************************************************************
+
+// Renders a synthetic underwater frame
+//     params    - scene parameters
+//     scene     - output 8-bit grayscale frame
+//     truthMask - if not NULL, receives the ground truth object mask
+//
+void generateUnderwaterScene(const SceneParams& params, Mat& scene, Mat* truthMask)
+{
+	RNG rng(params.seed);
+	Size size = params.size;
+
+	Mat frameImg(size, CV_32F);
+	renderBackground(rng, frameImg);
+
+	// objects are added on top of the background, with slightly soft edges
+	Mat objImg = Mat::zeros(size, CV_32F);
+	Mat truth = Mat::zeros(size, CV_8U);
+	for(int i = 0; i < params.objectCount; ++i)
+		renderObject(rng, params, objImg, truth);
+	GaussianBlur(objImg, objImg, Size(0, 0), 1.2);
+	frameImg += objImg;
+
+	// marine snow: small bright particles, not part of the truth
+	Mat snowImg = Mat::zeros(size, CV_32F);
+	int snowCount = size.area() / 20000;
+	for(int i = 0; i < snowCount; ++i){
+		Point p(rng.uniform(0, size.width), rng.uniform(0, size.height));
+		circle(snowImg, p, rng.uniform(1, 3), Scalar(rng.uniform(20.0, 60.0)), -1);
+	}
+	frameImg += snowImg;
+
+	// sensor noise
+	if(params.noiseSigma > 0){
+		Mat noise(size, CV_32F);
+		rng.fill(noise, RNG::NORMAL, 0, params.noiseSigma);
+		frameImg += noise;
+	}
+
+	frameImg.convertTo(scene, CV_8U);
+	if(truthMask)
+		truth.copyTo(*truthMask);
+}
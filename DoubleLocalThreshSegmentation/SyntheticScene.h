@@ -0,0 +1,42 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  SyntheticScene.h
+//  Date:   Oct/16/2026
+//
+//  Generator of synthetic frames that look like those of a trawl-based
+//  underwater camera: a dark, unevenly lit and hazy background, bright
+//  fish-like objects lit by the strobe, marine snow and sensor noise.
+//  Frames are deterministic for a given seed, so benchmark runs compare.
+//
+
+#ifndef _SYNTHETICSCENE_H_
+#define _SYNTHETICSCENE_H_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+using namespace std;
+using namespace cv;
+
+//********** scene parameters ****************************************************
+
+struct SceneParams
+{
+	SceneParams() : size(1280, 960), objectCount(8), objectSize(120), noiseSigma(6), seed(1) {}
+
+	Size		size;			// frame size
+	int			objectCount;	// number of objects
+	double		objectSize;		// mean body length of an object, in pixels
+	double		noiseSigma;		// standard deviation of the sensor noise
+	unsigned	seed;			// random seed
+};
+
+//********** functions *******************************************************************************
+
+// Renders a synthetic underwater frame
+//     params    - scene parameters
+//     scene     - output 8-bit grayscale frame
+//     truthMask - if not NULL, receives the ground truth object mask
+void generateUnderwaterScene(const SceneParams& params, Mat& scene, Mat* truthMask = NULL);
+
+#endif
@@ -0,0 +1,152 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  TiledSegmentation.cpp
+//  Date:   Oct/16/2026
+//
+
+#include "TiledSegmentation.h"
+
+// 64-bit file offsets, mosaics easily exceed 2 GB
+#ifdef _MSC_VER
+#define fseek64 _fseeki64
+#else
+#define fseek64 fseeko
+#endif
+
+//********** class RawImageFile **************************************************
+
+RawImageFile::RawImageFile()
+	: _file(NULL)
+{
+
+}
+
+RawImageFile::~RawImageFile()
+{
+	close();
+}
+
+// Opens a raw image file
+//     filename - path of the file
+//     size     - image size; when reading, the file must be at least this large
+//     writable - create the file (zero-filled) for writing instead of reading it
+//
+//     returns : false if the file cannot be opened or is too short
+//
+bool RawImageFile::open(const string& filename, Size size, bool writable)
+{
+	close();
+	_size = size;
+	_file = fopen(filename.c_str(), writable ? "w+b" : "rb");
+	if(!_file)
+		return false;
+
+	// extend a new file to its full size, or check that an existing one is complete
+	int64 bytes = (int64)size.width * size.height;
+	if(bytes == 0)
+		return true;
+	bool ok = writable ? (seek(size.width - 1, size.height - 1) && fputc(0, _file) != EOF)
+					   : (seek(size.width - 1, size.height - 1) && fgetc(_file) != EOF);
+	if(!ok)
+		close();
+	return ok;
+}
+
+void RawImageFile::close()
+{
+	if(_file){
+		fclose(_file);
+		_file = NULL;
+	}
+}
+
+bool RawImageFile::seek(int x, int y)
+{
+	return fseek64(_file, (int64)y * _size.width + x, SEEK_SET) == 0;
+}
+
+bool RawImageFile::read(const Rect& rect, Mat& tile)
+{
+	if(!_file) return false;
+	tile.create(rect.size(), CV_8U);
+	for(int y = 0; y < rect.height; ++y){
+		if(!seek(rect.x, rect.y + y) || fread(tile.ptr<uchar>(y), 1, rect.width, _file) != (size_t)rect.width)
+			return false;
+	}
+	return true;
+}
+
+bool RawImageFile::write(const Rect& rect, const Mat& tile)
+{
+	if(!_file) return false;
+	CV_Assert(tile.type() == CV_8U && tile.size() == rect.size());
+	for(int y = 0; y < rect.height; ++y){
+		if(!seek(rect.x, rect.y + y) || fwrite(tile.ptr<uchar>(y), 1, rect.width, _file) != (size_t)rect.width)
+			return false;
+	}
+	return true;
+}
+
+//********** class TiledSegmentation *********************************************
+
+// Turns temporal mode and the frame cache of an engine off for its lifetime:
+// temporal mode would diff each tile against the previous one, and the cache
+// would keep every tile's mask, so both are restored on any exit from run
+class TiledSegmentation::FrameModeScope
+{
+public:
+	explicit FrameModeScope(FGExtraction& segMgr)
+		: _segMgr(segMgr), _temporalMode(segMgr._temporalMode), _frameCacheCapacity(segMgr._frameCacheCapacity)
+	{
+		_segMgr._temporalMode = false;
+		_segMgr._frameCacheCapacity = 0;
+	}
+
+	~FrameModeScope()
+	{
+		_segMgr._temporalMode = _temporalMode;
+		_segMgr._frameCacheCapacity = _frameCacheCapacity;
+	}
+
+private:
+	FGExtraction&	_segMgr;
+	bool			_temporalMode;
+	int				_frameCacheCapacity;
+
+	FrameModeScope(const FrameModeScope&);
+	FrameModeScope& operator=(const FrameModeScope&);
+};
+
+TiledSegmentation::TiledSegmentation(FGExtraction& segMgr, int tileSize, int maxObjectSize)
+	: _segMgr(segMgr)
+{
+	// multiples of 16 keep every tile origin aligned with the coarsest pyramid level
+	_tileSize = (std::max(tileSize, 16) + 15) / 16 * 16;
+	_halo = (segMgr.tileHalo(maxObjectSize) + 15) / 16 * 16;
+}
+
+// Segments an image tile by tile
+//     src - input 8-bit grayscale image
+//     dst - output object mask of the same size
+//
+//     returns : false if a tile cannot be read or written
+//
+bool TiledSegmentation::run(TileSource& src, TileSink& dst)
+{
+	FrameModeScope frameMode(_segMgr);
+	Size size = src.size();
+	Rect imgRect(0, 0, size.width, size.height);
+	for(int y = 0; y < size.height; y += _tileSize){
+		for(int x = 0; x < size.width; x += _tileSize){
+			Rect core = Rect(x, y, _tileSize, _tileSize) & imgRect;
+			Rect tile = expandRect(core, _halo) & imgRect;
+			if(!src.read(tile, _tileImg))
+				return false;
+
+			_segMgr.extractForeground(_tileImg, _tileFgImg);
+			if(!dst.write(core, _tileFgImg(core - tile.tl())))
+				return false;
+		}
+	}
+	return true;
+}
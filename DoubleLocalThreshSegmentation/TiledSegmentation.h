@@ -0,0 +1,120 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  TiledSegmentation.h
+//  Date:   Oct/16/2026
+//
+//  Segmentation of images too large to hold in memory, e.g. stitched survey
+//  mosaics. The image is cut into square tiles, each tile is read with a
+//  halo around it, segmented by FGExtraction and only its core is written
+//  out. The halo covers the largest object, its 1.5x local region ellipse
+//  and the reach of every morphological filter, so an object crossing tile
+//  borders is segmented the same in each tile that sees it. Peak memory is
+//  that of one haloed tile, whatever the image size.
+//
+
+#ifndef _TILEDSEGMENTATION_H_
+#define _TILEDSEGMENTATION_H_
+
+#include <cstdio>
+#include <string>
+
+#include <opencv2/core/core.hpp>
+
+#include "FGExtraction.h"
+
+using namespace std;
+using namespace cv;
+
+//********** tile I/O interfaces *************************************************
+
+// image that can be read one rectangle at a time
+class TileSource
+{
+public:
+	virtual ~TileSource() {}
+	virtual Size size() const = 0;
+	virtual bool read(const Rect& rect, Mat& tile) = 0;
+};
+
+// image that can be written one rectangle at a time
+class TileSink
+{
+public:
+	virtual ~TileSink() {}
+	virtual bool write(const Rect& rect, const Mat& tile) = 0;
+};
+
+//********** class RawImageFile **************************************************
+
+// Headerless 8-bit grayscale image file, row after row, read and written in
+// place, so only the requested rectangle is ever in memory
+class RawImageFile : public TileSource, public TileSink
+{
+public:
+	RawImageFile();
+	~RawImageFile();
+
+	// opens an existing file for reading, or creates one of the given size for writing
+	bool open(const string& filename, Size size, bool writable);
+	void close();
+
+	Size size() const { return _size; }
+	bool read(const Rect& rect, Mat& tile);
+	bool write(const Rect& rect, const Mat& tile);
+
+private:
+	FILE*	_file;
+	Size	_size;
+
+	bool seek(int x, int y);
+
+	RawImageFile(const RawImageFile&);
+	RawImageFile& operator=(const RawImageFile&);
+};
+
+//********** class MatTiles ******************************************************
+
+// in-memory image as a tile source and sink
+class MatTiles : public TileSource, public TileSink
+{
+public:
+	explicit MatTiles(Mat img) : _img(img) {}
+
+	Size size() const { return _img.size(); }
+	bool read(const Rect& rect, Mat& tile) { _img(rect).copyTo(tile); return true; }
+	bool write(const Rect& rect, const Mat& tile) { Mat dst = _img(rect); tile.copyTo(dst); return true; }
+
+private:
+	Mat _img;
+};
+
+//********** class TiledSegmentation *********************************************
+
+class TiledSegmentation
+{
+public:
+	// tileSize      - side length of the tile cores, rounded up to a multiple of 16
+	// maxObjectSize - largest extent of an object in pixels; objects larger than
+	//                 this may be segmented differently than in the whole image
+	TiledSegmentation(FGExtraction& segMgr, int tileSize, int maxObjectSize);
+
+	int tileSize() const { return _tileSize; }
+	int halo() const { return _halo; }
+
+	// segments src tile by tile into dst, which has the size of src; the
+	// tiles are unrelated frames, so the engine's temporal mode and frame
+	// cache are off while it runs
+	//     returns : false if a tile cannot be read or written
+	bool run(TileSource& src, TileSink& dst);
+
+private:
+	class FrameModeScope;
+
+	FGExtraction&	_segMgr;
+	int				_tileSize;
+	int				_halo;
+	Mat				_tileImg;
+	Mat				_tileFgImg;
+};
+
+#endif
@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  WorkStealingPool.cpp
+//  Date:   Oct/16/2026
+//
+
+#include <algorithm>
+
+#include "WorkStealingPool.h"
+
+//********** class WorkStealingPool **********************************************
+
+WorkStealingPool::WorkStealingPool(int threads)
+	: _queued(0), _pending(0), _next(0), _stop(false)
+{
+	if(threads <= 0)
+		threads = std::max((int)std::thread::hardware_concurrency(), 1);
+
+	for(int i = 0; i < threads; ++i)
+		_queues.push_back(new WorkerQueue);
+
+	// workers only look their index up once all threads exist
+	std::lock_guard<std::mutex> lock(_mutex);
+	for(int i = 0; i < threads; ++i)
+		_threads.push_back(std::thread(&WorkStealingPool::workerLoop, this, i));
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	wait();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_wake.notify_all();
+	for(size_t i = 0; i < _threads.size(); ++i)
+		_threads[i].join();
+	for(size_t i = 0; i < _queues.size(); ++i)
+		delete _queues[i];
+}
+
+void WorkStealingPool::submit(const Task& task)
+{
+	int self = workerIndex();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		++_queued;
+		++_pending;
+		if(self < 0)
+			self = (int)(_next++ % _queues.size());
+	}
+	{
+		std::lock_guard<std::mutex> lock(_queues[self]->mutex);
+		_queues[self]->tasks.push_back(task);
+	}
+	_wake.notify_one();
+}
+
+void WorkStealingPool::wait()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while(_pending > 0)
+		_idle.wait(lock);
+}
+
+// index of the calling worker, -1 for threads outside the pool
+int WorkStealingPool::workerIndex() const
+{
+	std::thread::id id = std::this_thread::get_id();
+	for(size_t i = 0; i < _threads.size(); ++i)
+		if(_threads[i].get_id() == id)
+			return (int)i;
+	return -1;
+}
+
+// takes the newest task of the own deque, or else the oldest task of another one
+bool WorkStealingPool::tryPop(int self, Task& task)
+{
+	{
+		WorkerQueue& own = *_queues[self];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if(!own.tasks.empty()){
+			task = own.tasks.back();
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	int n = (int)_queues.size();
+	for(int k = 1; k < n; ++k){
+		WorkerQueue& victim = *_queues[(self + k) % n];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if(!victim.tasks.empty()){
+			task = victim.tasks.front();
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorkStealingPool::workerLoop(int self)
+{
+	{
+		// wait for the constructor to finish filling _threads
+		std::lock_guard<std::mutex> lock(_mutex);
+	}
+
+	for(;;){
+		Task task;
+		if(tryPop(self, task)){
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				--_queued;
+			}
+			task();
+			std::lock_guard<std::mutex> lock(_mutex);
+			if(--_pending == 0)
+				_idle.notify_all();
+			continue;
+		}
+
+		// a task counted in _queued but not pushed yet shows up shortly
+		std::unique_lock<std::mutex> lock(_mutex);
+		while(!_stop && _queued == 0)
+			_wake.wait(lock);
+		if(_stop && _queued == 0)
+			return;
+	}
+}
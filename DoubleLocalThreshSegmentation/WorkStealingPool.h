@@ -0,0 +1,68 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  WorkStealingPool.h
+//  Date:   Oct/16/2026
+//
+//  Fixed-size thread pool with one task deque per worker. A worker runs
+//  its own tasks newest first and, when it runs out, steals the oldest task
+//  of another worker, so tasks spawned by a busy task spread over all idle
+//  threads. Tasks may submit further tasks.
+//
+
+#ifndef _WORKSTEALINGPOOL_H_
+#define _WORKSTEALINGPOOL_H_
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+//********** class WorkStealingPool **********************************************
+
+class WorkStealingPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	// threads - number of workers, 0 for one per hardware thread
+	explicit WorkStealingPool(int threads = 0);
+	~WorkStealingPool();
+
+	int threadCount() const { return (int)_threads.size(); }
+
+	// queues a task on the calling worker's own deque, or on the next worker
+	// in turn when called from outside the pool
+	void submit(const Task& task);
+
+	// blocks until every submitted task, including those submitted by other
+	// tasks, has finished
+	void wait();
+
+private:
+	struct WorkerQueue
+	{
+		std::mutex			mutex;
+		std::deque<Task>	tasks;
+	};
+
+	std::vector<WorkerQueue*>	_queues;
+	std::vector<std::thread>	_threads;
+	std::mutex					_mutex;
+	std::condition_variable		_wake;		// tasks were queued or the pool stops
+	std::condition_variable		_idle;		// no task is pending
+	int							_queued;	// tasks in the deques
+	int							_pending;	// tasks queued or running
+	unsigned					_next;
+	bool						_stop;
+
+	int workerIndex() const;
+	bool tryPop(int self, Task& task);
+	void workerLoop(int self);
+
+	WorkStealingPool(const WorkStealingPool&);
+	WorkStealingPool& operator=(const WorkStealingPool&);
+};
+
+#endif
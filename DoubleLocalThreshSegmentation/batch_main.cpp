@@ -0,0 +1,217 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  batch_main.cpp
+//  Date:   Oct/16/2026
+//
+//  Offline segmentation of many independent still images. Frames and the
+//  local regions inside them share one work-stealing pool, and each mask
+//  is written as soon as its frame is done. Compressed images are decoded
+//  to grayscale by a pool of decode threads that runs a bounded number of
+//  frames ahead, so memory does not grow with the list; frames of a raw
+//  container are segmented in place, without any decoding.
+//
+//  Usage:
+//      DoubleLocalThreshBatch <list.txt | frames.dlraw> <output dir> [-j threads] [-d threads]
+//      DoubleLocalThreshBatch -p <list.txt> <frames.dlraw> [-d threads]
+//
+//      list.txt      text file with one image path per line
+//      frames.dlraw  raw grayscale frame container, see RawFrameFile.h
+//      output dir    masks are written there as seg_<image name>, or as
+//                    seg_<frame number>.png for a container
+//      -j threads    number of segmentation threads (default: one per hardware thread)
+//      -d threads    number of decode threads (default: 2)
+//      -p            pack the listed images into a raw container instead
+//
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include "util.h"
+#include "FGExtraction.h"
+#include "DecodePool.h"
+#include "RawFrameFile.h"
+
+//********** frame iterators *************************************************************************
+
+// input iterator over the images of a decode pool, in list order
+class DecodedFrameIterator
+{
+public:
+	DecodedFrameIterator() : _pool(NULL) {}
+	explicit DecodedFrameIterator(DecodePool& pool) : _pool(&pool) { ++*this; }
+
+	const Mat& operator*() const { return _img; }
+	DecodedFrameIterator& operator++()
+	{
+		if(_pool && !_pool->next(_img))
+			_pool = NULL;
+		return *this;
+	}
+	bool operator==(const DecodedFrameIterator& other) const { return _pool == other._pool; }
+	bool operator!=(const DecodedFrameIterator& other) const { return _pool != other._pool; }
+
+private:
+	DecodePool*	_pool;	// NULL at the end
+	Mat			_img;
+};
+
+// input iterator over the frames of a raw container, as headers into its mapping
+class RawFrameIterator
+{
+public:
+	RawFrameIterator(const RawFrameReader& reader, size_t pos) : _reader(&reader), _pos(pos) {}
+
+	Mat operator*() const { return _reader->frame(_pos); }
+	RawFrameIterator& operator++() { ++_pos; return *this; }
+	bool operator==(const RawFrameIterator& other) const { return _pos == other._pos; }
+	bool operator!=(const RawFrameIterator& other) const { return _pos != other._pos; }
+
+private:
+	const RawFrameReader*	_reader;
+	size_t					_pos;
+};
+
+//********** functions *******************************************************************************
+
+static bool endsWith(const string& str, const string& suffix)
+{
+	return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool readList(const string& listFile, vector<string>& filenames)
+{
+	ifstream list(listFile.c_str());
+	if(!list)
+		return false;
+	string line;
+	while(getline(list, line)){
+		if(!line.empty() && line[line.size()-1] == '\r')
+			line.erase(line.size()-1);
+		if(!line.empty())
+			filenames.push_back(line);
+	}
+	return true;
+}
+
+static void reportDecode(const DecodeStats& stats)
+{
+	cout << "decode: " << stats.frames << " images on " << stats.threads << " threads, "
+		 << stats.throughput() << " images/s sustainable, consumer waited " << stats.waitSeconds << " s" << endl;
+}
+
+// Decodes the listed images into a raw container
+//     filenames - images, all of the size of the first one
+//     outFile   - container to append to
+//     decoders  - number of decode threads
+//
+static int packFrames(const vector<string>& filenames, const string& outFile, int decoders)
+{
+	DecodePool pool(filenames, decoders);
+	RawFrameWriter writer;
+	int failed = 0;
+	Mat img;
+	size_t index;
+	while(pool.next(img, &index)){
+		if(img.empty()){
+			cerr << "cannot read " << filenames[index] << endl;
+			++failed;
+			continue;
+		}
+		if(!writer.isOpen() && !writer.open(outFile, img.size())){
+			cerr << "cannot write " << outFile << endl;
+			return 1;
+		}
+		if(!writer.write(img)){
+			cerr << filenames[index] << " differs in size from the first image or cannot be written" << endl;
+			++failed;
+		}
+	}
+	reportDecode(pool.stats());
+	return failed ? 1 : 0;
+}
+
+//********** main functions **************************************************************************
+
+int main(int argc, char** argv)
+{
+	bool pack = argc > 1 && string(argv[1]) == "-p";
+	int first = pack ? 2 : 1;
+	if(argc < first + 2){
+		cerr << "usage: " << argv[0] << " <list.txt | frames.dlraw> <output dir> [-j threads] [-d threads]" << endl
+			 << "       " << argv[0] << " -p <list.txt> <frames.dlraw> [-d threads]" << endl;
+		return 1;
+	}
+
+	string input = argv[first];
+	string output = argv[first + 1];
+	int threads = 0;
+	int decoders = 2;
+	for(int i = first + 2; i+1 < argc; i += 2){
+		if(string(argv[i]) == "-j")
+			threads = atoi(argv[i+1]);
+		else if(string(argv[i]) == "-d")
+			decoders = atoi(argv[i+1]);
+	}
+
+	// raw containers are mapped, image lists are decoded by the pool
+	bool raw = !pack && endsWith(input, ".dlraw");
+	RawFrameReader reader;
+	vector<string> filenames;
+	if(raw ? !reader.open(input) : !readList(input, filenames)){
+		cerr << "cannot read " << input << endl;
+		return 1;
+	}
+	if(pack)
+		return packFrames(filenames, output, decoders);
+	size_t frameCount = raw ? reader.frameCount() : filenames.size();
+
+	// set parameters
+	double minArea = 1000;
+	double maxArea = 1e12;
+	double minVar = 30;
+	double pHigh = 0.7;
+	double pLow = 1;
+	double theta = 0.3;
+	int nbins = 16;
+	int gradSESize = 5;
+	int areaSESize = 7;
+	int postSESize = 5;
+	FGExtraction segMgr(minArea, maxArea, minVar, pHigh, pLow, theta, nbins, gradSESize, areaSESize, postSESize);
+
+	// write each mask as its frame finishes; imwrite is safe from several threads
+	int failed = 0;
+	FGExtraction::FrameCallback writeMask = [&](size_t index, const Mat& fgImg) {
+		string name;
+		if(raw){
+			name = format("%06d.png", (int)index);
+		}
+		else{
+			const string& filename = filenames[index];
+			size_t slash = filename.find_last_of("/\\");
+			name = (slash == string::npos) ? filename : filename.substr(slash + 1);
+		}
+		if(fgImg.empty() || !imwrite(output + "/seg_" + name, fgImg))
+			CV_XADD(&failed, 1);
+	};
+
+	int64 start = getTickCount();
+	if(raw){
+		segMgr.extractForegroundBatch(RawFrameIterator(reader, 0), RawFrameIterator(reader, frameCount), writeMask, threads);
+	}
+	else{
+		DecodePool pool(filenames, decoders);
+		segMgr.extractForegroundBatch(DecodedFrameIterator(pool), DecodedFrameIterator(), writeMask, threads);
+		reportDecode(pool.stats());
+	}
+	double seconds = (getTickCount() - start) / getTickFrequency();
+
+	cout << "segmentation: " << frameCount << " images in " << seconds << " s (" << frameCount / std::max(seconds, 1e-9)
+		 << " images/s)" << endl;
+	if(failed)
+		cerr << failed << " images could not be read or written" << endl;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,488 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  bench_main.cpp
+//  Date:   Oct/16/2026
+//
+//  Benchmark of every stage of FGExtraction, and of extractForeground end
+//  to end, on synthetic underwater frames. Each combination of the listed
+//  frame sizes, object counts, object sizes and noise levels is one scene.
+//  Local region stages are timed over all regions of the frame.
+//
+//  Usage:
+//      DoubleLocalThreshBench [-s WxH,...] [-n count,...] [-z size,...] [-g sigma,...]
+//                             [-p level] [-f 0|1] [-u 0|1] [-i iterations] [-j results.json]
+//
+//      -s  frame sizes (default 640x480,1280x960,1920x1080)
+//      -n  object counts (default 8)
+//      -z  mean object lengths in pixels (default 120)
+//      -g  noise standard deviations (default 6)
+//      -p  pyramid level of coarse localization (default 0); above 0 the
+//          recall of the regions and the IoU of the final mask are also
+//          reported, both against full resolution localization
+//      -f  1 to benchmark FixedFGExtraction<16>, whose bin table is
+//          built at compile time, instead of FGExtraction (default 0)
+//      -u  0 to merge the region masks with calcHist and a float
+//          backprojection instead of the fused kernel (default 1)
+//      -i  timed iterations of each stage, after one warm-up run (default 10)
+//      -j  also write the results as JSON to this file
+//
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "util.h"
+#include "FGExtraction.h"
+#include "FixedFGExtraction.h"
+#include "SyntheticScene.h"
+
+//********** class StageBenchmark ************************************************
+
+// inputs of the local region stages, prepared once per scene
+struct BenchRegion
+{
+	Rect	window;		// region window in the frame
+	Mat		inROI;		// input inside the window
+	Mat		mask;		// elliptical ROI mask
+	Mat		highRaw;	// outputs of double local thresholding
+	Mat		lowRaw;
+	Mat		highImg;	// median-filtered high and low masks
+	Mat		lowImg;
+	Mat		fgImg;		// output of the histogram backprojection
+};
+
+// Runs the stages of one FGExtraction instance on one frame; each stage
+// reads inputs produced once by the earlier stages, so it is timed alone
+class StageBenchmark
+{
+public:
+	StageBenchmark(FGExtraction& segMgr, const Mat& inImg);
+
+	int regionCount() const { return (int)_regions.size(); }
+
+	// each returns the seconds spent in the stage for the whole frame
+	double coarseLocalization();
+	double otsuThreshold();
+	double doubleLocalThreshold();
+	double histBackproject();
+	double areaVarThreshold();
+	double postProcessing();
+	double extractForeground();
+
+	// fraction of the full resolution local regions that the current pyramid
+	// level also finds, i.e. with a window IoU of at least minIoU
+	//     maskIoU - receives the IoU of the final masks of both settings
+	static double localizationRecall(FGExtraction& segMgr, const Mat& inImg, double minIoU, double* maskIoU);
+
+private:
+	FGExtraction&		_segMgr;
+	Mat					_inImg;
+	vector<BenchRegion>	_regions;
+	Mat					_mergedImg;		// object mask before area/variance thresholding
+	Mat					_areaVarImg;	// object mask before post-processing
+	Mat					_outImg;
+
+	// scratch buffers of the first region slot, looked up on every use as
+	// extractForeground may resize the slots
+	static FGExtraction::RegionWorkspace& regionWorkspace(FGExtraction& segMgr);
+};
+
+StageBenchmark::StageBenchmark(FGExtraction& segMgr, const Mat& inImg)
+	: _segMgr(segMgr), _inImg(inImg)
+{
+	// the local regions come from coarse localization
+	vector<vector<Point>> contours;
+	_segMgr.coarseLocalize(_inImg, contours);
+	vector<RotatedRect> orientedBoxes;
+	ContourPoints points;
+	orientedBoundingBoxes(contours, orientedBoxes, points);
+
+	_mergedImg = Mat::zeros(_inImg.size(), CV_8U);
+	for(size_t i = 0; i < contours.size(); ++i){
+		BenchRegion region;
+		RotatedRect regionBox;
+		region.window = _segMgr.localRegionWindow(orientedBoxes[i], _inImg.size(), regionBox);
+		if(region.window.area() == 0)
+			continue;
+
+		region.inROI = _inImg(region.window);
+		region.mask = Mat::zeros(region.window.size(), CV_8U);
+		regionBox.center.x -= region.window.x;
+		regionBox.center.y -= region.window.y;
+		ellipse(region.mask, regionBox, Scalar(255), -1);
+
+		_segMgr.doubleLocalThreshold(region.inROI, region.highRaw, region.lowRaw, region.mask);
+		medianBlur(region.highRaw, region.highImg, 3);
+		medianBlur(region.lowRaw, region.lowImg, 3);
+
+		region.fgImg = Mat::zeros(region.window.size(), CV_8U);
+		Mat mergedROI = _mergedImg(region.window);
+		_segMgr.updateByHistBackproject(region.inROI, region.highImg, region.lowImg, mergedROI, region.mask, regionWorkspace(_segMgr));
+		_regions.push_back(region);
+	}
+
+	// inputs of the frame-level stages
+	_segMgr.thresholdByAreaVar(_inImg, _mergedImg, _areaVarImg);
+}
+
+FGExtraction::RegionWorkspace& StageBenchmark::regionWorkspace(FGExtraction& segMgr)
+{
+	if(segMgr._ws.regions.empty())
+		segMgr._ws.regions.resize(1);
+	return segMgr._ws.regions[0];
+}
+
+static double rectIoU(const Rect& a, const Rect& b)
+{
+	double inter = (a & b).area();
+	double uni = a.area() + b.area() - inter;
+	return uni > 0 ? inter / uni : 0;
+}
+
+double StageBenchmark::localizationRecall(FGExtraction& segMgr, const Mat& inImg, double minIoU, double* maskIoU)
+{
+	int level = segMgr.pyramidLevel();
+	vector<vector<Point>> pyrContours, fullContours;
+	Mat pyrMask, fullMask;
+	segMgr.coarseLocalize(inImg, pyrContours);
+	segMgr.extractForeground(inImg, pyrMask);
+	segMgr.setPyramidLevel(0);
+	segMgr.coarseLocalize(inImg, fullContours);
+	segMgr.extractForeground(inImg, fullMask);
+	segMgr.setPyramidLevel(level);
+
+	vector<RotatedRect> pyrBoxes, fullBoxes;
+	ContourPoints points;
+	orientedBoundingBoxes(pyrContours, pyrBoxes, points);
+	orientedBoundingBoxes(fullContours, fullBoxes, points);
+
+	vector<Rect> pyrWindows(pyrContours.size());
+	for(size_t i = 0; i < pyrContours.size(); ++i){
+		RotatedRect regionBox;
+		pyrWindows[i] = segMgr.localRegionWindow(pyrBoxes[i], inImg.size(), regionBox);
+	}
+
+	int found = 0;
+	for(size_t i = 0; i < fullContours.size(); ++i){
+		RotatedRect regionBox;
+		Rect window = segMgr.localRegionWindow(fullBoxes[i], inImg.size(), regionBox);
+		for(size_t j = 0; j < pyrWindows.size(); ++j){
+			if(rectIoU(window, pyrWindows[j]) >= minIoU){
+				++found;
+				break;
+			}
+		}
+	}
+
+	if(maskIoU){
+		double inter = countNonZero(pyrMask & fullMask);
+		double uni = countNonZero(pyrMask | fullMask);
+		*maskIoU = uni > 0 ? inter / uni : 1;
+	}
+	return fullContours.empty() ? 1 : double(found) / fullContours.size();
+}
+
+double StageBenchmark::coarseLocalization()
+{
+	vector<vector<Point>> contours;
+	int64 start = getTickCount();
+	_segMgr.coarseLocalize(_inImg, contours);
+	return (getTickCount() - start) / getTickFrequency();
+}
+
+double StageBenchmark::otsuThreshold()
+{
+	int u = 0;
+	int64 start = getTickCount();
+	for(size_t i = 0; i < _regions.size(); ++i)
+		_segMgr.getOtsuThreshold(_regions[i].inROI, 0, 255, &u, _regions[i].mask);
+	return (getTickCount() - start) / getTickFrequency();
+}
+
+double StageBenchmark::doubleLocalThreshold()
+{
+	int64 start = getTickCount();
+	for(size_t i = 0; i < _regions.size(); ++i){
+		BenchRegion& region = _regions[i];
+		_segMgr.doubleLocalThreshold(region.inROI, region.highRaw, region.lowRaw, region.mask);
+	}
+	return (getTickCount() - start) / getTickFrequency();
+}
+
+double StageBenchmark::histBackproject()
+{
+	int64 start = getTickCount();
+	for(size_t i = 0; i < _regions.size(); ++i){
+		BenchRegion& region = _regions[i];
+		_segMgr.updateByHistBackproject(region.inROI, region.highImg, region.lowImg, region.fgImg, region.mask, regionWorkspace(_segMgr));
+	}
+	return (getTickCount() - start) / getTickFrequency();
+}
+
+double StageBenchmark::areaVarThreshold()
+{
+	int64 start = getTickCount();
+	_segMgr.thresholdByAreaVar(_inImg, _mergedImg, _outImg);
+	return (getTickCount() - start) / getTickFrequency();
+}
+
+double StageBenchmark::postProcessing()
+{
+	int64 start = getTickCount();
+	_segMgr.postProcessing(_areaVarImg, _outImg);
+	return (getTickCount() - start) / getTickFrequency();
+}
+
+double StageBenchmark::extractForeground()
+{
+	int64 start = getTickCount();
+	_segMgr.extractForeground(_inImg, _outImg);
+	return (getTickCount() - start) / getTickFrequency();
+}
+
+//********** measurement *****************************************************************************
+
+struct StageStats
+{
+	string	stage;
+	double	minMs;
+	double	medianMs;
+	double	meanMs;
+};
+
+struct SceneResult
+{
+	SceneParams			scene;
+	int					pyramidLevel;
+	bool				fixedTables;
+	bool				fusedRegions;
+	int					regions;
+	double				recall;		// against full resolution localization
+	double				maskIoU;
+	vector<StageStats>	stages;
+};
+
+// times one stage: a warm-up run fills the workspace, then iterations timed runs
+static StageStats measure(StageBenchmark& bench, const string& stage, double (StageBenchmark::*run)(), int iterations)
+{
+	(bench.*run)();
+
+	vector<double> ms(iterations);
+	double total = 0;
+	for(int i = 0; i < iterations; ++i){
+		ms[i] = (bench.*run)() * 1000;
+		total += ms[i];
+	}
+	std::sort(ms.begin(), ms.end());
+
+	StageStats stats;
+	stats.stage = stage;
+	stats.minMs = ms.front();
+	stats.medianMs = iterations % 2 ? ms[iterations/2] : (ms[iterations/2 - 1] + ms[iterations/2]) / 2;
+	stats.meanMs = total / iterations;
+	return stats;
+}
+
+// benchmarks every stage on one synthetic scene
+static SceneResult benchmarkScene(const SceneParams& scene, int pyramidLevel, bool fixedTables, bool fusedRegions,
+								  int iterations)
+{
+	Mat inImg;
+	generateUnderwaterScene(scene, inImg);
+
+	// same parameters as test_main.cpp
+	double minArea = 1000;
+	double maxArea = inImg.rows * inImg.cols;
+	double minVar = 30;
+	double pHigh = 0.7;
+	double pLow = 1;
+	double theta = 0.3;
+	int nbins = 16;
+	int gradSESize = 5;
+	int areaSESize = 7;
+	int postSESize = 5;
+	FGExtraction dynamicMgr(minArea, maxArea, minVar, pHigh, pLow, theta, nbins, gradSESize, areaSESize, postSESize);
+	FixedFGExtraction<16> fixedMgr(minArea, maxArea, minVar, pHigh, pLow, theta, gradSESize, areaSESize, postSESize);
+	FGExtraction& segMgr = fixedTables ? fixedMgr : dynamicMgr;
+	segMgr.setPyramidLevel(pyramidLevel);
+	segMgr.setFusedRegions(fusedRegions);
+
+	StageBenchmark bench(segMgr, inImg);
+	SceneResult result;
+	result.scene = scene;
+	result.pyramidLevel = segMgr.pyramidLevel();
+	result.fixedTables = fixedTables;
+	result.fusedRegions = fusedRegions;
+	result.regions = bench.regionCount();
+	result.recall = 1;
+	result.maskIoU = 1;
+	if(result.pyramidLevel > 0)
+		result.recall = StageBenchmark::localizationRecall(segMgr, inImg, 0.5, &result.maskIoU);
+	result.stages.push_back(measure(bench, "coarse_localization", &StageBenchmark::coarseLocalization, iterations));
+	result.stages.push_back(measure(bench, "otsu_threshold", &StageBenchmark::otsuThreshold, iterations));
+	result.stages.push_back(measure(bench, "double_local_threshold", &StageBenchmark::doubleLocalThreshold, iterations));
+	result.stages.push_back(measure(bench, "hist_backproject", &StageBenchmark::histBackproject, iterations));
+	result.stages.push_back(measure(bench, "threshold_by_area_var", &StageBenchmark::areaVarThreshold, iterations));
+	result.stages.push_back(measure(bench, "post_processing", &StageBenchmark::postProcessing, iterations));
+	result.stages.push_back(measure(bench, "extract_foreground", &StageBenchmark::extractForeground, iterations));
+	return result;
+}
+
+//********** output **********************************************************************************
+
+static void printResult(const SceneResult& result)
+{
+	const SceneParams& scene = result.scene;
+	cout << scene.size.width << "x" << scene.size.height << ", " << scene.objectCount << " objects of "
+		 << scene.objectSize << " px, noise " << scene.noiseSigma << ", " << result.regions << " regions"
+		 << (result.fixedTables ? ", fixed tables" : "") << (result.fusedRegions ? "" : ", multi-pass regions") << endl;
+	if(result.pyramidLevel > 0){
+		cout << "    pyramid level " << result.pyramidLevel << ": recall " << fixed << setprecision(3) << result.recall
+			 << ", mask IoU " << result.maskIoU << endl;
+	}
+	for(size_t i = 0; i < result.stages.size(); ++i){
+		const StageStats& stats = result.stages[i];
+		cout << "    " << left << setw(24) << stats.stage << right << fixed << setprecision(3)
+			 << setw(10) << stats.medianMs << " ms median" << setw(10) << stats.minMs << " ms min" << endl;
+	}
+}
+
+static void writeJson(ostream& out, const vector<SceneResult>& results, int iterations)
+{
+	out << "{\n";
+	out << "  \"benchmark\": \"DoubleLocalThreshBench\",\n";
+	out << "  \"iterations\": " << iterations << ",\n";
+	out << "  \"threads\": " << getNumThreads() << ",\n";
+	out << "  \"results\": [\n";
+	for(size_t i = 0; i < results.size(); ++i){
+		const SceneResult& result = results[i];
+		const SceneParams& scene = result.scene;
+		out << "    {\n";
+		out << "      \"width\": " << scene.size.width << ", \"height\": " << scene.size.height
+			<< ", \"objects\": " << scene.objectCount << ", \"object_size\": " << scene.objectSize
+			<< ", \"noise\": " << scene.noiseSigma << ", \"seed\": " << scene.seed
+			<< ", \"pyramid_level\": " << result.pyramidLevel << ", \"fixed_tables\": " << (result.fixedTables ? "true" : "false")
+			<< ", \"fused_regions\": " << (result.fusedRegions ? "true" : "false")
+			<< ", \"regions\": " << result.regions
+			<< ", \"recall\": " << result.recall << ", \"mask_iou\": " << result.maskIoU << ",\n";
+		out << "      \"stages\": {\n";
+		for(size_t j = 0; j < result.stages.size(); ++j){
+			const StageStats& stats = result.stages[j];
+			out << "        \"" << stats.stage << "\": {\"min_ms\": " << stats.minMs
+				<< ", \"median_ms\": " << stats.medianMs << ", \"mean_ms\": " << stats.meanMs << "}"
+				<< (j+1 < result.stages.size() ? "," : "") << "\n";
+		}
+		out << "      }\n";
+		out << "    }" << (i+1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n";
+	out << "}\n";
+}
+
+//********** argument parsing ************************************************************************
+
+static vector<string> splitList(const string& list)
+{
+	vector<string> items;
+	stringstream ss(list);
+	string item;
+	while(getline(ss, item, ','))
+		if(!item.empty())
+			items.push_back(item);
+	return items;
+}
+
+static vector<Size> parseSizes(const string& list)
+{
+	vector<Size> sizes;
+	vector<string> items = splitList(list);
+	for(size_t i = 0; i < items.size(); ++i){
+		int width = 0, height = 0;
+		if(sscanf(items[i].c_str(), "%dx%d", &width, &height) == 2 && width > 0 && height > 0)
+			sizes.push_back(Size(width, height));
+	}
+	return sizes;
+}
+
+static vector<double> parseNumbers(const string& list)
+{
+	vector<double> values;
+	vector<string> items = splitList(list);
+	for(size_t i = 0; i < items.size(); ++i)
+		values.push_back(atof(items[i].c_str()));
+	return values;
+}
+
+//********** main functions **************************************************************************
+
+int main(int argc, char** argv)
+{
+	vector<Size> sizes = parseSizes("640x480,1280x960,1920x1080");
+	vector<double> counts(1, 8);
+	vector<double> objectSizes(1, 120);
+	vector<double> noises(1, 6);
+	int pyramidLevel = 0;
+	bool fixedTables = false;
+	bool fusedRegions = true;
+	int iterations = 10;
+	string jsonFile;
+
+	for(int i = 1; i < argc; ++i){
+		string arg = argv[i];
+		if(i+1 >= argc){
+			cerr << "usage: " << argv[0] << " [-s WxH,...] [-n count,...] [-z size,...] [-g sigma,...]"
+				 << " [-p level] [-f 0|1] [-u 0|1] [-i iterations] [-j results.json]" << endl;
+			return 1;
+		}
+		string value = argv[++i];
+		if(arg == "-s")
+			sizes = parseSizes(value);
+		else if(arg == "-n")
+			counts = parseNumbers(value);
+		else if(arg == "-z")
+			objectSizes = parseNumbers(value);
+		else if(arg == "-g")
+			noises = parseNumbers(value);
+		else if(arg == "-p")
+			pyramidLevel = atoi(value.c_str());
+		else if(arg == "-f")
+			fixedTables = atoi(value.c_str()) != 0;
+		else if(arg == "-u")
+			fusedRegions = atoi(value.c_str()) != 0;
+		else if(arg == "-i")
+			iterations = std::max(atoi(value.c_str()), 1);
+		else if(arg == "-j")
+			jsonFile = value;
+	}
+
+	// every combination of the scene parameters
+	vector<SceneResult> results;
+	for(size_t a = 0; a < sizes.size(); ++a)
+	for(size_t b = 0; b < counts.size(); ++b)
+	for(size_t c = 0; c < objectSizes.size(); ++c)
+	for(size_t d = 0; d < noises.size(); ++d){
+		SceneParams scene;
+		scene.size = sizes[a];
+		scene.objectCount = (int)counts[b];
+		scene.objectSize = objectSizes[c];
+		scene.noiseSigma = noises[d];
+		results.push_back(benchmarkScene(scene, pyramidLevel, fixedTables, fusedRegions, iterations));
+		printResult(results.back());
+	}
+
+	if(!jsonFile.empty()){
+		ofstream out(jsonFile.c_str());
+		if(!out){
+			cerr << "cannot write " << jsonFile << endl;
+			return 1;
+		}
+		writeJson(out, results, iterations);
+	}
+
+	return 0;
+}
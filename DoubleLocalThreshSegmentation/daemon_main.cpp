@@ -0,0 +1,121 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  daemon_main.cpp
+//  Date:   Oct/16/2026
+//
+//  Local segmentation service for the processes of one node, e.g. capture,
+//  tracking and QA viewers, which then share one pool of warm workers
+//  instead of each running its own FGExtraction. Clients link
+//  SegmentationClient and pass frames through shared memory; see
+//  SegmentationProtocol.h. SIGINT or SIGTERM stops the service once the
+//  queued frames are done.
+//
+//  Usage:
+//      DoubleLocalThreshDaemon <socket path> [-w workers] [-q capacity] [-p level] [-r seconds]
+//
+//      socket path   Unix domain socket to listen on, e.g. /tmp/dlts.sock
+//      -w workers    number of segmentation workers (default: one per hardware thread)
+//      -q capacity   frames waiting for a worker before clients are held back
+//                    (default: twice the workers)
+//      -p level      pyramid level of coarse localization (default 0)
+//      -r seconds    report the service counters every this many seconds (default 0, never)
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <csignal>
+#include <thread>
+#include <chrono>
+#include <atomic>
+
+#include "FGExtraction.h"
+#include "SegmentationServer.h"
+
+static SegmentationServer* runningServer = NULL;
+
+static void onSignal(int)
+{
+	if(runningServer)
+		runningServer->stop();
+}
+
+//********** main functions **************************************************************************
+
+int main(int argc, char** argv)
+{
+	if(argc < 2){
+		cerr << "usage: " << argv[0] << " <socket path> [-w workers] [-q capacity] [-p level] [-r seconds]" << endl;
+		return 1;
+	}
+
+	string socketPath = argv[1];
+	int workers = 0;
+	int capacity = 0;
+	int pyramidLevel = 0;
+	int reportInterval = 0;
+	for(int i = 2; i+1 < argc; i += 2){
+		string arg = argv[i];
+		if(arg == "-w")
+			workers = atoi(argv[i+1]);
+		else if(arg == "-q")
+			capacity = atoi(argv[i+1]);
+		else if(arg == "-p")
+			pyramidLevel = atoi(argv[i+1]);
+		else if(arg == "-r")
+			reportInterval = atoi(argv[i+1]);
+	}
+
+	// set parameters, as in batch_main.cpp
+	double minArea = 1000;
+	double maxArea = 1e12;
+	double minVar = 30;
+	double pHigh = 0.7;
+	double pLow = 1;
+	double theta = 0.3;
+	int nbins = 16;
+	int gradSESize = 5;
+	int areaSESize = 7;
+	int postSESize = 5;
+	FGExtraction segMgr(minArea, maxArea, minVar, pHigh, pLow, theta, nbins, gradSESize, areaSESize, postSESize);
+	segMgr.setPyramidLevel(pyramidLevel);
+
+	// the workers segment concurrently already, so regions stay on their worker
+	segMgr.setParallelRegions(false);
+
+	SegmentationServer server(segMgr, workers, capacity > 0 ? (size_t)capacity : 0);
+	if(!server.open(socketPath)){
+		cerr << "cannot listen on " << socketPath << " (path too long, in use, or not writable)" << endl;
+		return 1;
+	}
+
+	runningServer = &server;
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+	signal(SIGPIPE, SIG_IGN);
+
+	std::atomic<bool> done(false);
+	std::thread reporter;
+	if(reportInterval > 0){
+		reporter = std::thread([&server, &done, reportInterval]() {
+			while(!done){
+				for(int i = 0; i < reportInterval * 10 && !done; ++i)
+					std::this_thread::sleep_for(std::chrono::milliseconds(100));
+				ServiceStats stats = server.stats();
+				cout << stats.frames << " frames, " << stats.clients << " clients, " << stats.queued << " queued, "
+					 << stats.rejected << " rejected, " << stats.busySeconds << " s busy on " << stats.workers
+					 << " workers" << endl;
+			}
+		});
+	}
+
+	cout << "listening on " << socketPath << endl;
+	server.run();
+	done = true;
+	if(reporter.joinable())
+		reporter.join();
+	runningServer = NULL;
+
+	ServiceStats stats = server.stats();
+	cout << "stopped after " << stats.frames << " frames" << endl;
+	return 0;
+}
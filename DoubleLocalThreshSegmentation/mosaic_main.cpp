@@ -0,0 +1,82 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  mosaic_main.cpp
+//  Date:   Oct/16/2026
+//
+//  Tiled segmentation of a mosaic stored as a headerless 8-bit grayscale
+//  raw file. Tiles are read from and written to disk on demand, so memory
+//  use depends on the tile size only.
+//
+//  Usage:
+//      DoubleLocalThreshMosaic <input.raw> <width> <height> <output.raw> [-t tile size] [-m max object size]
+//
+//      -t tile size        side length of the tile cores (default 1024)
+//      -m max object size  largest object extent in pixels, sets the tile halo (default 400)
+//
+
+#include <iostream>
+#include <cstdlib>
+
+#include <opencv2/core/core.hpp>
+
+#include "util.h"
+#include "FGExtraction.h"
+#include "TiledSegmentation.h"
+
+//********** main functions **************************************************************************
+
+int main(int argc, char** argv)
+{
+	if(argc < 5){
+		cerr << "usage: " << argv[0] << " <input.raw> <width> <height> <output.raw> [-t tile size] [-m max object size]" << endl;
+		return 1;
+	}
+
+	string input = argv[1];
+	Size size(atoi(argv[2]), atoi(argv[3]));
+	string output = argv[4];
+	int tileSize = 1024;
+	int maxObjectSize = 400;
+	for(int i = 5; i+1 < argc; i += 2){
+		string arg = argv[i];
+		if(arg == "-t")
+			tileSize = atoi(argv[i+1]);
+		else if(arg == "-m")
+			maxObjectSize = atoi(argv[i+1]);
+	}
+
+	RawImageFile src, dst;
+	if(!src.open(input, size, false)){
+		cerr << "cannot read " << input << " as a " << size.width << "x" << size.height << " image" << endl;
+		return 1;
+	}
+	if(!dst.open(output, size, true)){
+		cerr << "cannot write " << output << endl;
+		return 1;
+	}
+
+	// set parameters, no object is larger than the halo allows
+	double minArea = 1000;
+	double maxArea = double(maxObjectSize) * maxObjectSize;
+	double minVar = 30;
+	double pHigh = 0.7;
+	double pLow = 1;
+	double theta = 0.3;
+	int nbins = 16;
+	int gradSESize = 5;
+	int areaSESize = 7;
+	int postSESize = 5;
+	FGExtraction segMgr(minArea, maxArea, minVar, pHigh, pLow, theta, nbins, gradSESize, areaSESize, postSESize);
+
+	TiledSegmentation tiler(segMgr, tileSize, maxObjectSize);
+	cout << "tiles of " << tiler.tileSize() << " px with a " << tiler.halo() << " px halo" << endl;
+
+	int64 start = getTickCount();
+	if(!tiler.run(src, dst)){
+		cerr << "I/O error while segmenting " << input << endl;
+		return 1;
+	}
+	cout << "done in " << (getTickCount() - start) / getTickFrequency() << " s" << endl;
+
+	return 0;
+}
@@ -0,0 +1,890 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  regress_main.cpp
+//  Date:   Oct/16/2026
+//
+//  Accuracy and throughput regression harness. The reference engine, with
+//  every optimization off, and the selected optimized modes segment the
+//  same corpus; each mode is reported side by side with its pixel-exact
+//  difference to the reference masks, its IoU against the ground truth
+//  where there is one, and its frame rate. The run fails when a mode
+//  differs from the reference by more than its tolerance, or when one of
+//  the selected checks fails.
+//
+//  Usage:
+//      DoubleLocalThreshRegress [-c corpus.txt] [-s WxH,...] [-n count,...] [-g sigma,...] [-k seeds]
+//                               [-m mode[:tolerance],...] [-t tolerance] [-i iterations] [-j results.json]
+//                               [-x check,...]
+//
+//      -c  corpus file, one "image [truth mask]" per line, # starts a comment;
+//          without it the corpus is synthetic
+//      -s  synthetic frame sizes (default 640x480,1280x960)
+//      -n  synthetic object counts (default 4,16)
+//      -g  synthetic noise standard deviations (default 6)
+//      -k  synthetic seeds per combination (default 2)
+//      -m  modes to check against the reference (default region,fast,fused,
+//          default,serial,fixed,batch,sweep,tiled; also pyramid1, pyramid2),
+//          each with an optional tolerance of its own
+//      -t  largest fraction of the pixels of a frame a mode may change
+//          (default 0, i.e. masks must be identical)
+//      -i  timed passes over the corpus, the fastest counts (default 3)
+//      -j  also write the results as JSON to this file
+//      -x  checks to run on the corpus, "none" for none (default alloc,objects,
+//          bitmask, and service where it is built):
+//          alloc   - repeating a frame allocates nothing in the workspace of
+//                    the reference or of any selected mode with its own engine
+//          objects - the objects of every frame read back from an object
+//                    container (DoubleLocalThreshRegress.dlo in the working
+//                    directory, removed afterwards) are those written, also
+//                    when the index lost entries or the last record is cut
+//          bitmask - BitMask logic, area, erosion and dilation give what
+//                    their OpenCV equivalents give on masks of every frame
+//          service - frames segmented by an in-process SegmentationServer
+//                    through a SegmentationClient come back with the masks
+//                    and objects of a local engine (POSIX builds only)
+//
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include "util.h"
+#include "BitMask.h"
+#include "FGExtraction.h"
+#include "FixedFGExtraction.h"
+#include "ObjectList.h"
+#include "ParameterSweep.h"
+#include "SyntheticScene.h"
+#include "TiledSegmentation.h"
+
+// the service is built on POSIX systems only, see CMakeLists.txt
+#ifdef DLTS_SERVICE
+#include <future>
+#include <thread>
+#include <unistd.h>
+
+#include "SegmentationServer.h"
+#include "SegmentationClient.h"
+#endif
+
+//********** corpus **********************************************************************************
+
+struct CorpusFrame
+{
+	string	name;
+	Mat		inImg;
+	Mat		truthMask;	// 0 and 255, empty without ground truth
+};
+
+struct ModeResult
+{
+	string	mode;
+	double	tolerance;
+	int64	diffPixels;		// pixels that differ from the reference, all frames
+	double	maxDiff;		// largest fraction of differing pixels of a frame
+	double	meanIoU;		// mean IoU against the ground truth, -1 without any
+	double	fps;
+	bool	passed;
+};
+
+struct CheckResult
+{
+	string	check;
+	string	mode;		// mode checked, empty if the check has none
+	string	detail;
+	bool	passed;
+};
+
+// same parameters as test_main.cpp, without an upper area limit
+static const FGParameters defaultParams = { 1000, 1e12, 30, 0.7, 1, 0.3, 16, 5, 7, 5 };
+
+// tile side of the tiled mode, small enough that most objects cross a tile border
+static const int tiledTileSize = 128;
+
+static bool readCorpus(const string& corpusFile, vector<CorpusFrame>& frames)
+{
+	ifstream corpus(corpusFile.c_str());
+	if(!corpus)
+		return false;
+	string line;
+	while(getline(corpus, line)){
+		stringstream ss(line);
+		string imageFile, truthFile;
+		if(!(ss >> imageFile) || imageFile[0] == '#')
+			continue;
+		ss >> truthFile;
+
+		CorpusFrame frame;
+		frame.name = imageFile;
+		frame.inImg = imread(imageFile, 0);
+		if(frame.inImg.empty()){
+			cerr << "cannot read " << imageFile << endl;
+			return false;
+		}
+		if(!truthFile.empty()){
+			frame.truthMask = imread(truthFile, 0);
+			if(frame.truthMask.size() != frame.inImg.size()){
+				cerr << "cannot read " << truthFile << " or its size differs from the image" << endl;
+				return false;
+			}
+			threshold(frame.truthMask, frame.truthMask, 0, 255, THRESH_BINARY);
+		}
+		frames.push_back(frame);
+	}
+	return true;
+}
+
+//********** modes ***********************************************************************************
+
+// Creates the engine of a mode
+//     mode - reference, region, fast, fused, default, serial, fixed,
+//            pyramid1 or pyramid2; batch, sweep and tiled use the default engine
+//
+//     returns : NULL for an unknown mode
+//
+static FGExtraction* createEngine(const string& mode)
+{
+	const FGParameters& p = defaultParams;
+	if(mode == "fixed")
+		return new FixedFGExtraction<16>(p.minArea, p.maxArea, p.minVar, p.pHigh, p.pLow, p.theta, p.gradSESize,
+										 p.areaSESize, p.postSESize);
+
+	FGExtraction* engine = new FGExtraction(p.minArea, p.maxArea, p.minVar, p.pHigh, p.pLow, p.theta, p.nbins,
+											p.gradSESize, p.areaSESize, p.postSESize);
+	if(mode == "reference" || mode == "region" || mode == "fast" || mode == "fused"){
+		// the original full-frame path, then one optimization at a time
+		engine->setRegionLocal(mode != "reference");
+		engine->setParallelRegions(false);
+		engine->setFastMorphology(mode == "fast");
+		engine->setFusedRegions(mode == "fused");
+		engine->setEmptyFrameCheck(false);
+	}
+	else if(mode == "serial")
+		engine->setParallelRegions(false);
+	else if(mode == "pyramid1" || mode == "pyramid2")
+		engine->setPyramidLevel(mode[7] - '0');
+	else if(mode != "default" && mode != "batch" && mode != "sweep" && mode != "tiled"){
+		delete engine;
+		return NULL;
+	}
+	return engine;
+}
+
+// Largest extent of the objects of a mask, for the halo of the tiled mode
+static int largestObjectSize(const Mat& fgImg)
+{
+	vector<vector<Point>> contours;
+	Mat contourImg = fgImg.clone();
+	findContours(contourImg, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+	int size = 1;
+	for(size_t i = 0; i < contours.size(); ++i){
+		Rect box = boundingRect(contours[i]);
+		size = std::max(size, std::max(box.width, box.height));
+	}
+	return size;
+}
+
+// Segments the corpus in one mode
+//     mode       - see createEngine
+//     frames     - corpus
+//     iterations - timed passes
+//     fgImgs     - receives the masks of the last pass
+//
+//     returns : seconds of the fastest pass, negative for an unknown mode
+//
+static double runMode(const string& mode, const vector<CorpusFrame>& frames, int iterations, vector<Mat>& fgImgs)
+{
+	FGExtraction* engine = createEngine(mode);
+	if(!engine)
+		return -1;
+
+	vector<Mat> inImgs(frames.size());
+	for(size_t i = 0; i < frames.size(); ++i)
+		inImgs[i] = frames[i].inImg;
+	vector<FGParameters> points(1, defaultParams);
+	ParameterSweep* sweep = mode == "sweep" ? new ParameterSweep(*engine) : NULL;
+
+	// the tiled mode sizes the halo of each frame for its largest object
+	vector<int> objectSizes;
+	if(mode == "tiled"){
+		Mat fullImg;
+		for(size_t i = 0; i < inImgs.size(); ++i){
+			engine->extractForeground(inImgs[i], fullImg);
+			objectSizes.push_back(largestObjectSize(fullImg));
+		}
+	}
+
+	// one untimed pass fills the workspaces
+	double best = -1;
+	for(int pass = 0; pass <= iterations; ++pass){
+		int64 start = getTickCount();
+		if(mode == "batch"){
+			engine->extractForegroundBatch(inImgs, fgImgs);
+		}
+		else if(sweep){
+			vector<vector<Mat>> sweepImgs;
+			sweep->run(inImgs, points, sweepImgs);
+			fgImgs.swap(sweepImgs[0]);
+		}
+		else if(mode == "tiled"){
+			fgImgs.resize(inImgs.size());
+			for(size_t i = 0; i < inImgs.size(); ++i){
+				TiledSegmentation tiler(*engine, tiledTileSize, objectSizes[i]);
+				fgImgs[i].create(inImgs[i].size(), CV_8U);
+				MatTiles src(inImgs[i]), dst(fgImgs[i]);
+				tiler.run(src, dst);
+			}
+		}
+		else{
+			fgImgs.resize(inImgs.size());
+			for(size_t i = 0; i < inImgs.size(); ++i)
+				engine->extractForeground(inImgs[i], fgImgs[i]);
+		}
+		double seconds = (getTickCount() - start) / getTickFrequency();
+		if(pass > 0 && (best < 0 || seconds < best))
+			best = seconds;
+	}
+
+	delete sweep;
+	delete engine;
+	return best;
+}
+
+static int64 diffPixels(const Mat& a, const Mat& b)
+{
+	if(a.size() != b.size())
+		return std::max(a.total(), b.total());
+	// both are masks of 0 and 255
+	Mat diff;
+	compare(a, b, diff, CMP_NE);
+	return countNonZero(diff);
+}
+
+static double maskIoU(const Mat& fgImg, const Mat& truthMask)
+{
+	double inter = countNonZero(fgImg & truthMask);
+	double uni = countNonZero(fgImg | truthMask);
+	return uni > 0 ? inter / uni : 1;
+}
+
+// Compares the masks of a mode with the reference masks and the ground truth
+static void scoreMode(ModeResult& result, const vector<CorpusFrame>& frames, const vector<Mat>& refImgs,
+					  const vector<Mat>& fgImgs, double seconds)
+{
+	result.diffPixels = 0;
+	result.maxDiff = 0;
+	double iouSum = 0;
+	int truthCount = 0;
+	for(size_t i = 0; i < frames.size(); ++i){
+		int64 diff = diffPixels(refImgs[i], fgImgs[i]);
+		result.diffPixels += diff;
+		result.maxDiff = std::max(result.maxDiff, double(diff) / std::max<size_t>(frames[i].inImg.total(), 1));
+		if(!frames[i].truthMask.empty()){
+			iouSum += maskIoU(fgImgs[i], frames[i].truthMask);
+			++truthCount;
+		}
+	}
+	result.meanIoU = truthCount ? iouSum / truthCount : -1;
+	result.fps = seconds > 0 ? frames.size() / seconds : 0;
+	result.passed = result.maxDiff <= result.tolerance;
+}
+
+//********** checks **********************************************************************************
+
+// Checks that the workspace of a mode stops allocating: each frame is
+// segmented once to size the buffers, then twice more, and the repeats must
+// leave allocationCount() unchanged
+//     mode   - see createEngine
+//     frames - corpus
+//     result - receives the outcome
+//
+static void checkAllocations(const string& mode, const vector<CorpusFrame>& frames, CheckResult& result)
+{
+	FGExtraction* engine = createEngine(mode);
+	int failedFrames = 0;
+	int allocations = 0;
+	Mat fgImg;
+	for(size_t i = 0; i < frames.size(); ++i){
+		engine->extractForeground(frames[i].inImg, fgImg);
+		int warm = engine->allocationCount();
+		for(int repeat = 0; repeat < 2; ++repeat)
+			engine->extractForeground(frames[i].inImg, fgImg);
+		int repeated = engine->allocationCount() - warm;
+		if(repeated > 0){
+			++failedFrames;
+			allocations += repeated;
+		}
+	}
+	delete engine;
+
+	result.check = "alloc";
+	result.mode = mode;
+	result.passed = failedFrames == 0;
+	result.detail = format("%d allocations on repeats of %d of %d frames", allocations, failedFrames,
+						   (int)frames.size());
+}
+
+// id under which the objects of corpus frame i are written, not its position
+static uint64 objectFrameId(size_t i)
+{
+	return 1000 + 7*(uint64)i;
+}
+
+static bool sameObjects(const vector<SegmentedObject>& a, const vector<SegmentedObject>& b)
+{
+	if(a.size() != b.size())
+		return false;
+	for(size_t i = 0; i < a.size(); ++i){
+		const vector<RLERun>& runsA = a[i].region.runs();
+		const vector<RLERun>& runsB = b[i].region.runs();
+		if(runsA.size() != runsB.size() ||
+		   (!runsA.empty() && memcmp(&runsA[0], &runsB[0], runsA.size() * sizeof(RLERun)) != 0))
+			return false;
+		const RotatedRect& boxA = a[i].orientedBox;
+		const RotatedRect& boxB = b[i].orientedBox;
+		if(a[i].boundingBox != b[i].boundingBox || a[i].area != b[i].area || a[i].mean != b[i].mean ||
+		   a[i].variance != b[i].variance || boxA.center != boxB.center || boxA.size != boxB.size ||
+		   boxA.angle != boxB.angle)
+			return false;
+	}
+	return true;
+}
+
+static bool readBytes(const string& filename, vector<char>& bytes)
+{
+	ifstream in(filename.c_str(), ios::binary);
+	bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+	return !in.bad() && in.is_open();
+}
+
+static bool writeBytes(const string& filename, const vector<char>& bytes, size_t size)
+{
+	ofstream out(filename.c_str(), ios::binary | ios::trunc);
+	out.write(bytes.empty() ? NULL : &bytes[0], std::min(size, bytes.size()));
+	return out.good();
+}
+
+// Reads an object container back and compares it with the objects written
+//     filename     - container
+//     frames       - corpus
+//     frameObjects - objects written for each frame
+//     count        - number of leading frames that must be found; the others
+//                    must not be
+//
+//     returns : the first difference, empty if there is none
+//
+static string compareObjectList(const string& filename, const vector<CorpusFrame>& frames,
+								const vector<vector<SegmentedObject>>& frameObjects, size_t count)
+{
+	ObjectListReader reader;
+	if(!reader.open(filename))
+		return "cannot read " + filename;
+	if(reader.frameCount() != count)
+		return format("%d frames found instead of %d", (int)reader.frameCount(), (int)count);
+
+	vector<SegmentedObject> objects;
+	for(size_t i = 0; i < frames.size(); ++i){
+		int pos = reader.findFrame(objectFrameId(i));
+		if(i >= count){
+			if(pos >= 0)
+				return format("frame %d is found although its record is cut", (int)i);
+			continue;
+		}
+		Size frameSize;
+		if(pos < 0 || !reader.readFrame(pos, objects, &frameSize))
+			return format("frame %d cannot be read back", (int)i);
+		if(frameSize != frames[i].inImg.size() || !sameObjects(objects, frameObjects[i]))
+			return format("frame %d reads back differently", (int)i);
+	}
+	return string();
+}
+
+// Checks that an object container returns what was written: the objects of
+// every frame by the default engine are written, read back by id and
+// compared field by field, then again after the index lost its last entry
+// (the record is found by scanning) and after the last record was cut short
+// (it is dropped, the others stay readable)
+//     frames - corpus
+//     result - receives the outcome
+//
+static void checkObjectList(const vector<CorpusFrame>& frames, CheckResult& result)
+{
+	const string filename = "DoubleLocalThreshRegress.dlo";
+	const string indexFilename = filename + ".idx";
+	const size_t indexEntryBytes = 16;	// u64 frame id, u64 offset, see ObjectList.h
+
+	FGExtraction* engine = createEngine("default");
+	vector<vector<SegmentedObject>> frameObjects(frames.size());
+	size_t objectCount = 0;
+	for(size_t i = 0; i < frames.size(); ++i){
+		engine->extractObjects(frames[i].inImg, frameObjects[i]);
+		objectCount += frameObjects[i].size();
+	}
+	delete engine;
+
+	remove(filename.c_str());
+	remove(indexFilename.c_str());
+	ObjectListWriter writer;
+	bool written = writer.open(filename);
+	for(size_t i = 0; written && i < frames.size(); ++i)
+		written = writer.write(objectFrameId(i), frames[i].inImg.size(), frameObjects[i]);
+	writer.close();
+
+	string failure = written ? compareObjectList(filename, frames, frameObjects, frames.size())
+							 : "cannot write " + filename;
+	vector<char> container, index;
+	if(failure.empty() && (!readBytes(filename, container) || !readBytes(indexFilename, index) ||
+						   index.size() < indexEntryBytes))
+		failure = "cannot read " + filename + " or its index";
+
+	// an interrupted writer: the last index entry never made it to the disk
+	if(failure.empty()){
+		if(!writeBytes(indexFilename, index, index.size() - indexEntryBytes))
+			failure = "cannot write " + indexFilename;
+		else{
+			failure = compareObjectList(filename, frames, frameObjects, frames.size());
+			if(!failure.empty())
+				failure = "lost index entry: " + failure;
+		}
+	}
+
+	// a crash in the middle of the last record, whose index entry is there
+	if(failure.empty()){
+		if(!writeBytes(indexFilename, index, index.size()) || !writeBytes(filename, container, container.size() - 4))
+			failure = "cannot write " + filename;
+		else{
+			failure = compareObjectList(filename, frames, frameObjects, frames.size() - 1);
+			if(!failure.empty())
+				failure = "cut last record: " + failure;
+		}
+	}
+	remove(filename.c_str());
+	remove(indexFilename.c_str());
+
+	result.check = "objects";
+	result.mode = "default";
+	result.passed = failure.empty();
+	result.detail = result.passed ? format("%d objects of %d frames read back", (int)objectCount, (int)frames.size())
+								  : failure;
+}
+
+static bool sameBits(const BitMask& bits, const Mat& expected)
+{
+	Mat actual;
+	bits.toMat(actual);
+	return diffPixels(actual, expected) == 0;
+}
+
+// Checks the BitMask operations against OpenCV on two masks thresholded
+// from each frame, cropped to a width that is not a multiple of 64 so that
+// the padding bits of the last word matter; erosion and dilation are tried
+// with elliptical SEs and with an even-sized rectangle, whose anchor is off
+// center
+//     frames - corpus
+//     result - receives the outcome
+//
+static void checkBitMask(const vector<CorpusFrame>& frames, CheckResult& result)
+{
+	vector<Mat> ses;
+	for(int seSize = 3; seSize <= 7; seSize += 2)
+		ses.push_back(getStructuringElement(MORPH_ELLIPSE, Size(seSize, seSize)));
+	ses.push_back(getStructuringElement(MORPH_RECT, Size(4, 3)));
+	vector<vector<MorphSpan>> seSpans(ses.size());
+	for(size_t k = 0; k < ses.size(); ++k)
+		structuringElementSpans(ses[k], Point(-1, -1), seSpans[k]);
+
+	string failure;
+	for(size_t i = 0; i < frames.size() && failure.empty(); ++i){
+		const Mat& inImg = frames[i].inImg;
+		Rect crop(0, 0, std::max(inImg.cols - 13, 1), std::max(inImg.rows - 5, 1));
+		Mat flipped, maskA, maskB;
+		compare(inImg(crop), 60, maskA, CMP_GT);
+		flip(inImg, flipped, 1);
+		compare(flipped(crop), 50, maskB, CMP_GT);
+
+		BitMask a(maskA), b(maskB), bits;
+		Mat expected;
+		if(a.area() != countNonZero(maskA))
+			failure = "area";
+
+		bits = a;
+		bits &= b;
+		bitwise_and(maskA, maskB, expected);
+		if(failure.empty() && !sameBits(bits, expected))
+			failure = "&=";
+
+		bits = a;
+		bits |= b;
+		bitwise_or(maskA, maskB, expected);
+		if(failure.empty() && !sameBits(bits, expected))
+			failure = "|=";
+
+		bits = a;
+		bits.andNot(b);
+		bitwise_and(maskA, ~maskB, expected);
+		if(failure.empty() && !sameBits(bits, expected))
+			failure = "andNot";
+
+		for(size_t k = 0; k < ses.size() && failure.empty(); ++k){
+			a.erode(bits, seSpans[k]);
+			erode(maskA, expected, ses[k]);
+			if(!sameBits(bits, expected))
+				failure = format("erode with SE %d", (int)k);
+			a.dilate(bits, seSpans[k]);
+			dilate(maskA, expected, ses[k]);
+			if(failure.empty() && !sameBits(bits, expected))
+				failure = format("dilate with SE %d", (int)k);
+		}
+		if(!failure.empty())
+			failure = "frame " + frames[i].name + ": " + failure + " differs from OpenCV";
+	}
+
+	result.check = "bitmask";
+	result.passed = failure.empty();
+	result.detail = result.passed ? format("logic, area and %d SEs on %d frames", (int)ses.size(), (int)frames.size())
+								  : failure;
+}
+
+#ifdef DLTS_SERVICE
+// Checks the segmentation service end to end: a server with the default
+// engine runs on a thread of this process, every frame is submitted through
+// a client for its mask and objects, and both must equal what the same
+// engine returns locally; the service counters must add up as well
+//     frames - corpus
+//     result - receives the outcome
+//
+static void checkService(const vector<CorpusFrame>& frames, CheckResult& result)
+{
+	FGExtraction* engine = createEngine("default");
+	SegmentationServer server(*engine, 2);
+	string socketPath = format("/tmp/DoubleLocalThreshRegress.%d.sock", (int)getpid());
+	string failure;
+	std::thread serverThread;
+	if(server.open(socketPath))
+		serverThread = std::thread(&SegmentationServer::run, &server);
+	else
+		failure = "cannot listen on " + socketPath;
+
+	Size maxFrameSize;
+	for(size_t i = 0; i < frames.size(); ++i){
+		maxFrameSize.width = std::max(maxFrameSize.width, frames[i].inImg.cols);
+		maxFrameSize.height = std::max(maxFrameSize.height, frames[i].inImg.rows);
+	}
+	SegmentationClient client;
+	if(failure.empty() && !client.connect(socketPath, maxFrameSize, 4))
+		failure = "cannot connect to " + socketPath;
+
+	// submit blocks while all slots are in flight, the results come in meanwhile
+	vector<std::future<SegmentationResult>> results;
+	for(size_t i = 0; i < frames.size() && failure.empty(); ++i)
+		results.push_back(client.submit(frames[i].inImg, RESULT_MASK | RESULT_OBJECTS));
+
+	vector<SegmentedObject> objects;
+	Mat fgImg;
+	for(size_t i = 0; i < results.size() && failure.empty(); ++i){
+		SegmentationResult served = results[i].get();
+		engine->extractObjects(frames[i].inImg, objects, fgImg);
+		if(!served.ok)
+			failure = "frame " + frames[i].name + " failed in the service";
+		else if(diffPixels(served.fgImg, fgImg) != 0)
+			failure = "frame " + frames[i].name + ": the served mask differs";
+		else if(!sameObjects(served.objects, objects))
+			failure = "frame " + frames[i].name + ": the served objects differ";
+	}
+
+	ServiceStats stats;
+	if(failure.empty()){
+		if(!client.serviceStats(stats))
+			failure = "no service counters";
+		else if(stats.frames != frames.size() || stats.rejected != 0)
+			failure = format("the service counted %d frames and %d rejected requests", (int)stats.frames,
+							 (int)stats.rejected);
+	}
+	client.close();
+	if(serverThread.joinable()){
+		server.stop();
+		serverThread.join();
+	}
+	delete engine;
+
+	result.check = "service";
+	result.mode = "default";
+	result.passed = failure.empty();
+	result.detail = result.passed ? format("%d frames served", (int)frames.size()) : failure;
+}
+#endif
+
+// Runs a check
+//     check   - alloc, objects, bitmask or service
+//     frames  - corpus
+//     modes   - selected modes, with their tolerances
+//     results - receives one result per checked mode
+//
+//     returns : false for an unknown check
+//
+static bool runCheck(const string& check, const vector<CorpusFrame>& frames, const vector<string>& modes,
+					 vector<CheckResult>& results)
+{
+	if(check == "alloc"){
+		// batches and sweeps start from fresh workspaces on every call, and tiles differ in size
+		vector<string> engineModes(1, "reference");
+		for(size_t i = 0; i < modes.size(); ++i){
+			string mode = modes[i].substr(0, modes[i].find(':'));
+			if(mode != "reference" && mode != "batch" && mode != "sweep" && mode != "tiled")
+				engineModes.push_back(mode);
+		}
+		for(size_t i = 0; i < engineModes.size(); ++i){
+			CheckResult result;
+			checkAllocations(engineModes[i], frames, result);
+			results.push_back(result);
+		}
+		return true;
+	}
+	if(check == "objects" || check == "bitmask"){
+		CheckResult result;
+		if(check == "objects")
+			checkObjectList(frames, result);
+		else
+			checkBitMask(frames, result);
+		results.push_back(result);
+		return true;
+	}
+#ifdef DLTS_SERVICE
+	if(check == "service"){
+		CheckResult result;
+		checkService(frames, result);
+		results.push_back(result);
+		return true;
+	}
+#endif
+	return false;
+}
+
+//********** output **********************************************************************************
+
+static void printResult(const ModeResult& result)
+{
+	cout << left << setw(12) << result.mode << right << fixed
+		 << setw(12) << result.diffPixels << setprecision(5) << setw(12) << result.maxDiff
+		 << setw(12) << result.tolerance << setprecision(3);
+	if(result.meanIoU >= 0)
+		cout << setw(10) << result.meanIoU;
+	else
+		cout << setw(10) << "-";
+	cout << setprecision(2) << setw(10) << result.fps << "  " << (result.passed ? "ok" : "FAILED") << endl;
+}
+
+static void printCheck(const CheckResult& result)
+{
+	cout << left << setw(12) << result.check << setw(12) << result.mode << right
+		 << result.detail << "  " << (result.passed ? "ok" : "FAILED") << endl;
+}
+
+static void writeJson(ostream& out, const vector<ModeResult>& results, const vector<CheckResult>& checks,
+					  size_t frameCount, int iterations)
+{
+	out << "{\n";
+	out << "  \"benchmark\": \"DoubleLocalThreshRegress\",\n";
+	out << "  \"frames\": " << frameCount << ",\n";
+	out << "  \"iterations\": " << iterations << ",\n";
+	out << "  \"results\": [\n";
+	for(size_t i = 0; i < results.size(); ++i){
+		const ModeResult& result = results[i];
+		out << "    {\"mode\": \"" << result.mode << "\", \"tolerance\": " << result.tolerance
+			<< ", \"diff_pixels\": " << result.diffPixels << ", \"max_diff\": " << result.maxDiff
+			<< ", \"mean_iou\": " << result.meanIoU << ", \"fps\": " << result.fps
+			<< ", \"passed\": " << (result.passed ? "true" : "false") << "}"
+			<< (i+1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ],\n";
+	out << "  \"checks\": [\n";
+	for(size_t i = 0; i < checks.size(); ++i){
+		const CheckResult& check = checks[i];
+		out << "    {\"check\": \"" << check.check << "\", \"mode\": \"" << check.mode
+			<< "\", \"detail\": \"" << check.detail << "\", \"passed\": " << (check.passed ? "true" : "false") << "}"
+			<< (i+1 < checks.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n";
+	out << "}\n";
+}
+
+//********** argument parsing ************************************************************************
+
+static vector<string> splitList(const string& list)
+{
+	vector<string> items;
+	stringstream ss(list);
+	string item;
+	while(getline(ss, item, ','))
+		if(!item.empty())
+			items.push_back(item);
+	return items;
+}
+
+static vector<Size> parseSizes(const string& list)
+{
+	vector<Size> sizes;
+	vector<string> items = splitList(list);
+	for(size_t i = 0; i < items.size(); ++i){
+		int width = 0, height = 0;
+		if(sscanf(items[i].c_str(), "%dx%d", &width, &height) == 2 && width > 0 && height > 0)
+			sizes.push_back(Size(width, height));
+	}
+	return sizes;
+}
+
+static vector<double> parseNumbers(const string& list)
+{
+	vector<double> values;
+	vector<string> items = splitList(list);
+	for(size_t i = 0; i < items.size(); ++i)
+		values.push_back(atof(items[i].c_str()));
+	return values;
+}
+
+//********** main functions **************************************************************************
+
+int main(int argc, char** argv)
+{
+	string corpusFile;
+	vector<Size> sizes = parseSizes("640x480,1280x960");
+	vector<double> counts = parseNumbers("4,16");
+	vector<double> noises(1, 6);
+	int seeds = 2;
+	vector<string> modes = splitList("region,fast,fused,default,serial,fixed,batch,sweep,tiled");
+	double tolerance = 0;
+	int iterations = 3;
+	string jsonFile;
+#ifdef DLTS_SERVICE
+	vector<string> checks = splitList("alloc,objects,bitmask,service");
+#else
+	vector<string> checks = splitList("alloc,objects,bitmask");
+#endif
+
+	for(int i = 1; i < argc; ++i){
+		string arg = argv[i];
+		if(i+1 >= argc){
+			cerr << "usage: " << argv[0] << " [-c corpus.txt] [-s WxH,...] [-n count,...] [-g sigma,...] [-k seeds]"
+				 << " [-m mode[:tolerance],...] [-t tolerance] [-i iterations] [-j results.json] [-x check,...]" << endl;
+			return 1;
+		}
+		string value = argv[++i];
+		if(arg == "-c")
+			corpusFile = value;
+		else if(arg == "-s")
+			sizes = parseSizes(value);
+		else if(arg == "-n")
+			counts = parseNumbers(value);
+		else if(arg == "-g")
+			noises = parseNumbers(value);
+		else if(arg == "-k")
+			seeds = std::max(atoi(value.c_str()), 1);
+		else if(arg == "-m")
+			modes = splitList(value);
+		else if(arg == "-t")
+			tolerance = atof(value.c_str());
+		else if(arg == "-i")
+			iterations = std::max(atoi(value.c_str()), 1);
+		else if(arg == "-j")
+			jsonFile = value;
+		else if(arg == "-x")
+			checks = value == "none" ? vector<string>() : splitList(value);
+	}
+
+	// the corpus, either listed or rendered with its ground truth
+	vector<CorpusFrame> frames;
+	if(!corpusFile.empty()){
+		if(!readCorpus(corpusFile, frames)){
+			cerr << "cannot read the corpus " << corpusFile << endl;
+			return 1;
+		}
+	}
+	else{
+		for(size_t a = 0; a < sizes.size(); ++a)
+		for(size_t b = 0; b < counts.size(); ++b)
+		for(size_t c = 0; c < noises.size(); ++c)
+		for(int seed = 1; seed <= seeds; ++seed){
+			SceneParams scene;
+			scene.size = sizes[a];
+			scene.objectCount = (int)counts[b];
+			scene.noiseSigma = noises[c];
+			scene.seed = seed;
+			CorpusFrame frame;
+			frame.name = format("synthetic_%dx%d_n%d_g%g_s%d", scene.size.width, scene.size.height,
+								scene.objectCount, scene.noiseSigma, seed);
+			generateUnderwaterScene(scene, frame.inImg, &frame.truthMask);
+			frames.push_back(frame);
+		}
+	}
+	if(frames.empty()){
+		cerr << "the corpus is empty" << endl;
+		return 1;
+	}
+
+	// the reference masks everything else is held to
+	vector<Mat> refImgs;
+	vector<ModeResult> results(1);
+	results[0].mode = "reference";
+	results[0].tolerance = 0;
+	double seconds = runMode("reference", frames, iterations, refImgs);
+	scoreMode(results[0], frames, refImgs, refImgs, seconds);
+
+	cout << frames.size() << " frames, fastest of " << iterations << " passes" << endl;
+	cout << left << setw(12) << "mode" << right << setw(12) << "diff px" << setw(12) << "max diff"
+		 << setw(12) << "tolerance" << setw(10) << "IoU" << setw(10) << "frames/s" << endl;
+	printResult(results[0]);
+
+	bool passed = true;
+	for(size_t i = 0; i < modes.size(); ++i){
+		ModeResult result;
+		size_t colon = modes[i].find(':');
+		result.mode = modes[i].substr(0, colon);
+		result.tolerance = colon == string::npos ? tolerance : atof(modes[i].c_str() + colon + 1);
+
+		vector<Mat> fgImgs;
+		seconds = runMode(result.mode, frames, iterations, fgImgs);
+		if(seconds < 0){
+			cerr << "unknown mode " << result.mode << endl;
+			return 1;
+		}
+		scoreMode(result, frames, refImgs, fgImgs, seconds);
+		printResult(result);
+		results.push_back(result);
+		passed = passed && result.passed;
+	}
+
+	vector<CheckResult> checkResults;
+	for(size_t i = 0; i < checks.size(); ++i){
+		size_t first = checkResults.size();
+		if(!runCheck(checks[i], frames, modes, checkResults)){
+			cerr << "unknown check " << checks[i] << endl;
+			return 1;
+		}
+		for(size_t j = first; j < checkResults.size(); ++j){
+			printCheck(checkResults[j]);
+			passed = passed && checkResults[j].passed;
+		}
+	}
+
+	if(!jsonFile.empty()){
+		ofstream out(jsonFile.c_str());
+		if(!out){
+			cerr << "cannot write " << jsonFile << endl;
+			return 1;
+		}
+		writeJson(out, results, checkResults, frames.size(), iterations);
+	}
+
+	if(!passed)
+		cerr << "some modes changed the masks beyond their tolerance or some checks failed" << endl;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,236 @@
+//////////////////////////////////////////////////////////////////////////
+//
+//  stream_main.cpp
+//  Date:   Oct/16/2026
+//
+//  Headless streaming segmentation of a video file, a numbered image
+//  sequence (e.g. "frames/%05d.jpg") or a raw frame container (.dlraw,
+//  see RawFrameFile.h), whose frames are passed on without decoding or
+//  copying. Decoding, segmentation and mask writing run as three
+//  overlapped stages connected by bounded queues, so the sustained frame
+//  rate is that of the slowest stage.
+//
+//  Usage:
+//      DoubleLocalThreshStream <input> [output pattern] [-q capacity] [-r interval] [-t trace.json]
+//
+//      input           video file, printf-style image sequence pattern or .dlraw container
+//      output pattern  printf-style mask file pattern, e.g. "seg/%06d.png";
+//                      masks are not written if omitted
+//      -q capacity     capacity of each queue between stages (default 4)
+//      -r interval     report the frame rate every interval frames (default 100)
+//      -t trace.json   write a Chrome trace of the segmentation stages and regions
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <thread>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include "util.h"
+#include "FGExtraction.h"
+#include "BoundedQueue.h"
+#include "RawFrameFile.h"
+
+//********** pipeline data ***************************************************************************
+
+struct StreamFrame
+{
+	int index;
+	Mat image;
+	Mat mask;
+};
+
+// busy time of one stage, in ticks, excluding time blocked on the queues
+struct StageTimer
+{
+	StageTimer() : ticks(0), frames(0) {}
+	int64 ticks;
+	int frames;
+
+	double seconds() const { return ticks / getTickFrequency(); }
+};
+
+//********** pipeline stages *************************************************************************
+
+// decodes frames and converts them to grayscale
+static void decodeStage(VideoCapture* capture, BoundedQueue<StreamFrame>* outQueue, StageTimer* timer)
+{
+	for(int index = 0; ; ++index){
+		int64 start = getTickCount();
+		StreamFrame frame;
+		frame.index = index;
+		if(!capture->read(frame.image) || frame.image.empty())
+			break;
+		if(frame.image.channels() > 1)
+			cvtColor(frame.image, frame.image, COLOR_BGR2GRAY);
+		timer->ticks += getTickCount() - start;
+		++timer->frames;
+
+		if(!outQueue->push(frame))
+			break;
+	}
+	outQueue->close();
+}
+
+// passes on the frames of a raw container as headers into its mapping
+static void rawStage(const RawFrameReader* reader, BoundedQueue<StreamFrame>* outQueue, StageTimer* timer)
+{
+	for(size_t index = 0; index < reader->frameCount(); ++index){
+		int64 start = getTickCount();
+		StreamFrame frame;
+		frame.index = (int)index;
+		frame.image = reader->frame(index);
+		timer->ticks += getTickCount() - start;
+		++timer->frames;
+
+		if(!outQueue->push(frame))
+			break;
+	}
+	outQueue->close();
+}
+
+// segments frames in arrival order
+static void segmentStage(FGExtraction* segMgr, BoundedQueue<StreamFrame>* inQueue,
+						 BoundedQueue<StreamFrame>* outQueue, StageTimer* timer)
+{
+	StreamFrame frame;
+	while(inQueue->pop(frame)){
+		int64 start = getTickCount();
+		segMgr->extractForeground(frame.image, frame.mask);
+		frame.image.release();
+		timer->ticks += getTickCount() - start;
+		++timer->frames;
+
+		if(!outQueue->push(frame)){
+			inQueue->close();
+			break;
+		}
+	}
+	outQueue->close();
+}
+
+// writes masks and reports the sustained frame rate
+static void writeStage(const string& outPattern, int reportInterval, BoundedQueue<StreamFrame>* inQueue, StageTimer* timer)
+{
+	int64 windowStart = getTickCount();
+	StreamFrame frame;
+	while(inQueue->pop(frame)){
+		int64 start = getTickCount();
+		if(!outPattern.empty()){
+			string filename = format(outPattern.c_str(), frame.index);
+			if(!imwrite(filename, frame.mask)){
+				cerr << "cannot write " << filename << endl;
+				inQueue->close();
+				break;
+			}
+		}
+		int64 now = getTickCount();
+		timer->ticks += now - start;
+		++timer->frames;
+
+		if(reportInterval > 0 && timer->frames % reportInterval == 0){
+			double fps = reportInterval / ((now - windowStart) / getTickFrequency());
+			cout << "frame " << frame.index + 1 << ": " << fixed << setprecision(2) << fps << " fps" << endl;
+			windowStart = now;
+		}
+	}
+}
+
+//********** main functions **************************************************************************
+
+int main(int argc, char** argv)
+{
+	if(argc < 2){
+		cerr << "usage: " << argv[0] << " <input> [output pattern] [-q capacity] [-r interval] [-t trace.json]" << endl;
+		return 1;
+	}
+
+	string input = argv[1];
+	string outPattern;
+	size_t queueCapacity = 4;
+	int reportInterval = 100;
+	string traceFile;
+	for(int i = 2; i < argc; ++i){
+		string arg = argv[i];
+		if(arg == "-q" && i+1 < argc)
+			queueCapacity = (size_t)atoi(argv[++i]);
+		else if(arg == "-r" && i+1 < argc)
+			reportInterval = atoi(argv[++i]);
+		else if(arg == "-t" && i+1 < argc)
+			traceFile = argv[++i];
+		else
+			outPattern = arg;
+	}
+
+	// raw containers are mapped, anything else goes through VideoCapture
+	bool raw = input.size() > 6 && input.compare(input.size() - 6, 6, ".dlraw") == 0;
+	RawFrameReader reader;
+	VideoCapture capture;
+	if(raw ? !reader.open(input) : !capture.open(input)){
+		cerr << "cannot open " << input << endl;
+		return 1;
+	}
+
+	// the first frame fixes the frame size for the area limit
+	Mat firstImg;
+	if(raw ? reader.frameCount() == 0 : !capture.read(firstImg) || firstImg.empty()){
+		cerr << "no frames in " << input << endl;
+		return 1;
+	}
+	if(raw){
+		firstImg = reader.frame(0);
+	}
+	else{
+		capture.release();
+		capture.open(input);
+	}
+
+	// set parameters
+	double minArea = 1000;
+	double maxArea = firstImg.rows * firstImg.cols;
+	double minVar = 30;
+	double pHigh = 0.7;
+	double pLow = 1;
+	double theta = 0.3;
+	int nbins = 16;
+	int gradSESize = 5;
+	int areaSESize = 7;
+	int postSESize = 5;
+	FGExtraction segMgr(minArea, maxArea, minVar, pHigh, pLow, theta, nbins, gradSESize, areaSESize, postSESize);
+
+	TraceSink trace;
+	if(!traceFile.empty()){
+		if(!trace.open(traceFile)){
+			cerr << "cannot write " << traceFile << endl;
+			return 1;
+		}
+		segMgr.setTraceSink(&trace);
+	}
+
+	// run the three stages, each queue applies backpressure to its producer
+	BoundedQueue<StreamFrame> decodedQueue(queueCapacity);
+	BoundedQueue<StreamFrame> segmentedQueue(queueCapacity);
+	StageTimer decodeTimer, segmentTimer, writeTimer;
+
+	int64 start = getTickCount();
+	std::thread decoder = raw ? std::thread(rawStage, &reader, &decodedQueue, &decodeTimer)
+							  : std::thread(decodeStage, &capture, &decodedQueue, &decodeTimer);
+	std::thread segmenter(segmentStage, &segMgr, &decodedQueue, &segmentedQueue, &segmentTimer);
+	writeStage(outPattern, reportInterval, &segmentedQueue, &writeTimer);
+	decodedQueue.close();
+	segmenter.join();
+	decoder.join();
+	double elapsed = (getTickCount() - start) / getTickFrequency();
+
+	// report the sustained frame rate and where the time went
+	int frames = writeTimer.frames;
+	cout << frames << " frames in " << fixed << setprecision(2) << elapsed << " s, "
+		 << (elapsed > 0 ? frames / elapsed : 0.0) << " fps" << endl;
+	cout << "stage busy time: decode " << decodeTimer.seconds() << " s, segment "
+		 << segmentTimer.seconds() << " s, write " << writeTimer.seconds() << " s" << endl;
+
+	return 0;
+}
@@ -11,6 +11,7 @@
 //
 
 #include <iostream>
+#include <cstdio>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
@@ -18,6 +19,7 @@
 
 #include "util.h"
 #include "FGExtraction.h"
+#include "ObjectList.h"
 
 //********** main functions **************************************************************************
 
@@ -42,14 +44,22 @@ int main(int argc, char** argv)
 
 	// apply object segmentation
 	FGExtraction segMgr(minArea, maxArea, minVar, pHigh, pLow, theta, nbins, gradSESize, areaSESize, postSESize);
-	segMgr.extractForeground(inImg, fgImg);
+	vector<SegmentedObject> objects;
+	segMgr.extractObjects(inImg, objects, fgImg);
 
-	// show and save the result
+	// show the result and save the objects in a container, which keeps the
+	// masks exactly and is much cheaper to write and read than an image;
+	// the container is written anew, so frame id 0 stays unique
 	imshow("input", inImg);
 	imshow("segmentation", fgImg);
 	waitKey(0);
-	filename = "seg_" + filename;
-	imwrite(filename, fgImg);
+	filename = "seg_" + filename.substr(0, filename.rfind('.')) + ".dlo";
+	remove(filename.c_str());
+	ObjectListWriter writer;
+	if(!writer.open(filename) || !writer.write(0, inImg.size(), objects)){
+		cerr << "cannot write " << filename << endl;
+		return 1;
+	}
 
 	return 0;
 }
\ No newline at end of file
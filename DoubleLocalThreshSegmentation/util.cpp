@@ -57,14 +57,21 @@ void drawOneContour(Mat img, const vector<Point>& contour, Scalar color, int thi
 // wrapper to find contours in a grayscale image
 vector<vector<Point>> extractContours(const Mat& img)
 {
-	Mat imgC1 = img.clone();
+	Mat tempImg;
+	return extractContours(img, tempImg);
+}
+
+// wrapper to find contours in a grayscale image
+// scratch receives the copy that findContours modifies, so it can be reused
+vector<vector<Point>> extractContours(const Mat& img, Mat& scratch)
+{
 	if(img.channels() != 1)
-		cvtColor(img, imgC1, COLOR_BGR2GRAY);
+		cvtColor(img, scratch, COLOR_BGR2GRAY);
+	else
+		img.copyTo(scratch);
 	
 	vector<vector<Point> > contours;
-	Mat tempImg = imgC1.clone();
-	findContours(tempImg, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE, Point());
-	tempImg.release();
+	findContours(scratch, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE, Point());
 	return contours;
 }
 
@@ -94,80 +101,154 @@ double Gaussian(double x, double stdev)
 	return exp( -pow(x, 2) / (2*pow(stdev, 2)) ) / stdev / sqrt(2*CV_PI);
 }
 
-// generate oriented bounding box
-// find the rotation angle by principal component analysis (PCA)
-RotatedRect orientedBoundingBox(const vector<Point>& contour)
+// oriented bounding box of n points given in struct-of-arrays layout
+// the principal axes come in closed form from the 2x2 covariance of the
+// points, which is what PCA computes on the same data
+static RotatedRect orientedBoxOfPoints(const float* xs, const float* ys, int n)
 {
-	if(contour.empty())
-		return RotatedRect();
-
 	RotatedRect orientedBox;
-	if(contour.size() <= 2){
-		if(contour.size() == 1){
-			orientedBox.center = contour[0];
+	if(n == 0)
+		return orientedBox;
+	if(n <= 2){
+		if(n == 1){
+			orientedBox.center = Point2f(xs[0], ys[0]);
 		}
 		else{
-			orientedBox.center.x = 0.5f*(contour[0].x + contour[1].x);
-			orientedBox.center.y = 0.5f*(contour[0].x + contour[1].x);
-			double dx = contour[1].x - contour[0].x;
-			double dy = contour[1].y - contour[0].y;
+			orientedBox.center.x = 0.5f*(xs[0] + xs[1]);
+			orientedBox.center.y = 0.5f*(ys[0] + ys[1]);
+			double dx = xs[1] - xs[0];
+			double dy = ys[1] - ys[0];
 			orientedBox.size.width = (float)sqrt(dx*dx + dy*dy);
 			orientedBox.size.height = 0;
-			orientedBox.angle = (float)atan2(dy, dx) * 180 / CV_PI;
+			orientedBox.angle = (float)(atan2(dy, dx) * 180 / CV_PI);
 		}
 		return orientedBox;
 	}
 
-	Mat data = Mat::zeros(2, contour.size(), CV_32F);
-	for(int j = 0; j < contour.size(); ++j){
-		data.at<float>(0, j) = contour[j].x;
-		data.at<float>(1, j) = contour[j].y;
+	// raw moments; integer coordinates keep the double sums exact
+	double m10 = 0, m01 = 0, m20 = 0, m11 = 0, m02 = 0;
+	for(int j = 0; j < n; ++j){
+		double x = xs[j], y = ys[j];
+		m10 += x;
+		m01 += y;
+		m20 += x*x;
+		m11 += x*y;
+		m02 += y*y;
 	}
+	double meanX = m10 / n, meanY = m01 / n;
+	double mu20 = m20 - m10*meanX;
+	double mu11 = m11 - m10*meanY;
+	double mu02 = m02 - m01*meanY;
 
-	// find the principal components
-	PCA pcaObj (data, noArray(), CV_DATA_AS_COL);
-	Mat result;
-	pcaObj.project(data, result);
+	// first eigenvector of [mu20 mu11; mu11 mu02] at angle phi, second one at phi + 90
+	double phi = 0.5 * atan2(2*mu11, mu20 - mu02);
+	float c = (float)cos(phi), s = (float)sin(phi);
 
-	// find two endpoints in principal component's direction      
+	// extent along both axes; the mean lies inside, so the ranges contain 0
+	float mx = (float)meanX, my = (float)meanY;
 	float maxU = 0, maxV = 0;
 	float minU = 0, minV = 0;
-
-	for(int j = 0; j < result.cols; ++j){
-		float u = result.at<float>(0, j);
-		float v = result.at<float>(1, j);
-		if(u > 0 && u > maxU) 
-			maxU = u;
-		else if(u < 0 && u < minU)
-			minU = u;
-
-		if(v > 0 && v > maxV)
-			maxV = v;  
-		else if(v < 0 && v < minV)
-			minV = v;
+	for(int j = 0; j < n; ++j){
+		float dx = xs[j] - mx, dy = ys[j] - my;
+		float u = dx*c + dy*s;
+		float v = dy*c - dx*s;
+		maxU = std::max(maxU, u);
+		minU = std::min(minU, u);
+		maxV = std::max(maxV, v);
+		minV = std::min(minV, v);
 	}
 
-	float cenU = 0.5*(maxU + minU);
-	float cenV = 0.5*(maxV + minV);
+	float cenU = 0.5f*(maxU + minU);
+	float cenV = 0.5f*(maxV + minV);
 
-	Mat cenUVMat = (Mat_<float>(2, 1) << cenU, cenV);
-	Mat cenXYMat = pcaObj.backProject(cenUVMat);
+	// the center is truncated to integers, as it always has been
+	orientedBox.center = Point((int)(mx + cenU*c - cenV*s), (int)(my + cenU*s + cenV*c));
+	orientedBox.size = Size2f(maxU - minU, maxV - minV);
+	orientedBox.angle = (float)(phi * 180 / CV_PI);
+	return orientedBox;
+}
 
-	Point cen(cenXYMat.at<float>(0, 0), cenXYMat.at<float>(1, 0));
+// generate oriented bounding box
+// the rotation angle is that of the principal component of the contour points
+RotatedRect orientedBoundingBox(const vector<Point>& contour)
+{
+	vector<float> xs(contour.size()), ys(contour.size());
+	for(size_t j = 0; j < contour.size(); ++j){
+		xs[j] = (float)contour[j].x;
+		ys[j] = (float)contour[j].y;
+	}
+	return orientedBoxOfPoints(xs.data(), ys.data(), (int)contour.size());
+}
 
-	// get width and height of the oriented bounding box
-	float width = maxU - minU;
-	float height = maxV - minV;
+// Oriented bounding boxes of many contours, as orientedBoundingBox computes them
+//     contours - contours of the objects
+//     boxes    - receives one box per contour
+//     points   - buffer for the points of all contours, reused from call to call
+//
+void orientedBoundingBoxes(const vector<vector<Point>>& contours, vector<RotatedRect>& boxes, ContourPoints& points)
+{
+	size_t total = 0;
+	for(size_t i = 0; i < contours.size(); ++i)
+		total += contours[i].size();
+
+	points.x.resize(total);
+	points.y.resize(total);
+	points.start.resize(contours.size() + 1);
+	int k = 0;
+	for(size_t i = 0; i < contours.size(); ++i){
+		points.start[i] = k;
+		const vector<Point>& contour = contours[i];
+		for(size_t j = 0; j < contour.size(); ++j, ++k){
+			points.x[k] = (float)contour[j].x;
+			points.y[k] = (float)contour[j].y;
+		}
+	}
+	points.start[contours.size()] = k;
 
-	Mat pc = pcaObj.eigenvectors;
+	boxes.resize(contours.size());
+	for(size_t i = 0; i < contours.size(); ++i){
+		int start = points.start[i];
+		boxes[i] = orientedBoxOfPoints(points.x.data() + start, points.y.data() + start, points.start[i+1] - start);
+	}
+}
 
-	float pcx = pc.at<float>(0, 0);
-	float pcy = pc.at<float>(0, 1);
-	float theta = atan2(pcy, pcx) * 180 / 3.1415927;
+// bounding rectangle of all pixels touched by ellipse(img, box, color, -1)
+// the polygon is generated exactly the way cv::ellipse does it (16-bit fixed
+// point, angle rounded to degrees), so the rectangle is tight but never clips
+// the rasterized ellipse
+Rect ellipseBoundingRect(const RotatedRect& box)
+{
+	const int shift = 16;
+	Point center(cvRound(box.center.x*(1 << shift)), cvRound(box.center.y*(1 << shift)));
+	Size axes(cvRound(box.size.width*(1 << (shift-1))), cvRound(box.size.height*(1 << (shift-1))));
+	axes.width = std::abs(axes.width);
+	axes.height = std::abs(axes.height);
+
+	int delta = (std::max(axes.width, axes.height) + (1 << (shift-1))) >> shift;
+	delta = delta < 3 ? 90 : delta < 10 ? 30 : delta < 15 ? 18 : 5;
+
+	vector<Point> pts;
+	ellipse2Poly(center, axes, cvRound(box.angle), 0, 360, delta, pts);
+	if(pts.empty())
+		return Rect(center.x >> shift, center.y >> shift, 1, 1);
+
+	int xmin = pts[0].x, xmax = pts[0].x;
+	int ymin = pts[0].y, ymax = pts[0].y;
+	for(size_t i = 1; i < pts.size(); ++i){
+		xmin = std::min(xmin, pts[i].x);
+		xmax = std::max(xmax, pts[i].x);
+		ymin = std::min(ymin, pts[i].y);
+		ymax = std::max(ymax, pts[i].y);
+	}
 
-	// define the oriented bounding box
-	orientedBox.center = cen;
-	orientedBox.size = Size2f(width, height);
-	orientedBox.angle = theta;
-	return orientedBox;
+	// one extra pixel on each side for the outline drawn around the polygon
+	int x0 = (xmin >> shift) - 1, x1 = (xmax >> shift) + 2;
+	int y0 = (ymin >> shift) - 1, y1 = (ymax >> shift) + 2;
+	return Rect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+}
+
+// grow a rectangle by a margin on every side
+Rect expandRect(const Rect& rect, int margin)
+{
+	return Rect(rect.x - margin, rect.y - margin, rect.width + 2*margin, rect.height + 2*margin);
 }
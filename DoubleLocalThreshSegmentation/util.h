@@ -16,6 +16,7 @@
 #include <iostream>
 #include <cmath>
 #include <iomanip>
+#include <algorithm>
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
@@ -112,6 +113,38 @@ private:
 	vector<T> _vec;
 };
 
+/*
+ * Growable scratch buffer handing out Mat headers of any geometry that fits
+ * its capacity, so reusing it for an equal or smaller size allocates nothing;
+ * the headers are valid until the next request that makes the buffer grow
+ */
+class ScratchMat
+{
+public:
+	Mat get(Size size, int type, int* allocCounter = 0){
+		size_t bytes = (size_t)size.area() * CV_ELEM_SIZE(type);
+		if(_buf.empty() || bytes > _buf.total()){
+			_buf.create(1, (int)std::max(bytes, (size_t)1), CV_8U);
+			if(allocCounter)
+				CV_XADD(allocCounter, 1);
+		}
+		return Mat(size, type, _buf.data);
+	}
+private:
+	Mat _buf;
+};
+
+/*
+ * Points of many contours in struct-of-arrays layout: the x and y
+ * coordinates of all contours back to back, contour i at [start[i], start[i+1])
+ */
+struct ContourPoints
+{
+	vector<float> x;
+	vector<float> y;
+	vector<int> start;
+};
+
 //********** functions *******************************************************************************
 
 void printType(Mat mat);
@@ -125,10 +158,14 @@ string decToBin(int number);
 double Gaussian(double x, double stdev);
 
 vector<vector<Point>> extractContours(const Mat& img);
+vector<vector<Point>> extractContours(const Mat& img, Mat& scratch);
 void edgeDetection(InputArray src, OutputArray dst);
 void calcColorHist(const Mat* image, InputArray mask, OutputArray hist);
 
 RotatedRect orientedBoundingBox(const vector<Point>& contour);
+void orientedBoundingBoxes(const vector<vector<Point>>& contours, vector<RotatedRect>& boxes, ContourPoints& points);
+Rect ellipseBoundingRect(const RotatedRect& box);
+Rect expandRect(const Rect& rect, int margin);
 
 vector<Point> deformContour(InputArray src, const vector<Point>& contour, const vector<Point>& refContour);
 